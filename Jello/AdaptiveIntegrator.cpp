@@ -0,0 +1,213 @@
+#include "AdaptiveIntegrator.h"
+#include "Physics.h"
+
+#include <algorithm>
+#include <cmath>
+
+// step size control: next = step * clamp(SAFETY * error^(-1/3), MIN_FACTOR, MAX_FACTOR)
+static const double SAFETY = 0.9;
+static const double MIN_FACTOR = 0.2;
+static const double MAX_FACTOR = 5.0;
+
+// drops the buffers and the step size carried over, the next topology starts from the fixed step again
+template <typename Real>
+void AdaptiveIntegrator<Real>::clear() {
+    this->buffers.clear();
+    this->stage.clear();
+    this->nextStep = 0.0;
+}
+
+/**
+ * lays out the stage state and the stage derivatives for the current topology
+ * @param const ParticleStore <Real>& current - state at the start of the step
+ */
+template <typename Real>
+void AdaptiveIntegrator<Real>::prepare(const ParticleStore <Real>& current) {
+    const int count = current.size();
+    if (!this->buffers.fits(count)) {
+        Arena& arena = this->buffers.resize(count, 0, ParticleStore <Real>::bytesFor(count) + 18 * Arena::bytesFor<Real>(count));
+        this->stage.allocate(arena, count);
+
+        for (int s = 0; s < 3; s++) {
+            for (int c = 0; c < 6; c++) {
+                this->k[s][c] = arena.allocate<Real>(count);
+            }
+        }
+    }
+
+    // fixed points may change with the topology while the point count stays the same
+    this->stage.copyFlags(current);
+}
+
+/**
+ * keeps the derivative (velocity, acceleration) of a state as stage k[index]
+ * @param int index - stage
+ * @param const ParticleStore <Real>& state - state with computed accelerations
+ */
+template <typename Real>
+void AdaptiveIntegrator<Real>::storeDerivative(int index, const ParticleStore <Real>& state) {
+    Real* const* derivative = this->k[index];
+
+    #pragma omp parallel for
+    for (int i = 0; i < state.size(); i++) {
+        derivative[0][i] = state.vx[i]; derivative[1][i] = state.vy[i]; derivative[2][i] = state.vz[i];
+        derivative[3][i] = state.ax[i]; derivative[4][i] = state.ay[i]; derivative[5][i] = state.az[i];
+    }
+}
+
+/**
+ * writes the state the next stage is evaluated at, stage = current + dt * sum(weights[s] * k[s])
+ * @param const ParticleStore <Real>& current - state at the start of the step
+ * @param Real timeStep - dt
+ * @param const Real weights[3] - weight of every stored stage derivative
+ */
+template <typename Real>
+void AdaptiveIntegrator<Real>::setStage(const ParticleStore <Real>& current, Real timeStep, const Real weights[3]) {
+    ParticleStore <Real>& s = this->stage;
+    Real* const state[6] = { s.px, s.py, s.pz, s.vx, s.vy, s.vz };
+    const Real* const start[6] = { current.px, current.py, current.pz, current.vx, current.vy, current.vz };
+
+    #pragma omp parallel for
+    for (int i = 0; i < current.size(); i++) {
+        const bool fixed = current.isFixed(i);
+        for (int c = 0; c < 6; c++) {
+            Real change = Real(0);
+            for (int stage = 0; stage < 3; stage++) {
+                change += weights[stage] * this->k[stage][c][i];
+            }
+            // fixed points do not move
+            state[c][i] = fixed ? start[c][i] : start[c][i] + timeStep * change;
+        }
+    }
+}
+
+/**
+ * scaled root mean square of the difference between the 3rd and 2nd order solutions,
+ * the step is within the tolerance when it is at most 1
+ * the stage holds the 3rd order solution and its derivative (k4)
+ * @param const ParticleStore <Real>& current - state at the start of the step
+ * @param Real timeStep - dt
+ * @param double tolerance - relative tolerance, also absolute for positions and velocities near 0
+ * @return double - error norm
+ */
+template <typename Real>
+double AdaptiveIntegrator<Real>::errorNorm(const ParticleStore <Real>& current, Real timeStep, double tolerance) {
+    // b - b*, Bogacki-Shampine
+    const double e1 = -5.0 / 72.0, e2 = 1.0 / 12.0, e3 = 1.0 / 9.0, e4 = -1.0 / 8.0;
+    const ParticleStore <Real>& s = this->stage;
+    const Real* const state[6] = { s.px, s.py, s.pz, s.vx, s.vy, s.vz };
+    const Real* const start[6] = { current.px, current.py, current.pz, current.vx, current.vy, current.vz };
+    const Real* const last[6] = { s.vx, s.vy, s.vz, s.ax, s.ay, s.az };
+    const double dt = double(timeStep);
+
+    double sum = 0.0;
+    int moving = 0;
+    #pragma omp parallel for reduction(+:sum, moving)
+    for (int i = 0; i < current.size(); i++) {
+        if (current.isFixed(i)) {
+            continue;
+        }
+        moving++;
+        for (int c = 0; c < 6; c++) {
+            const double error = dt * (e1 * this->k[0][c][i] + e2 * this->k[1][c][i] + e3 * this->k[2][c][i] + e4 * last[c][i]);
+            const double scale = tolerance * (1.0 + std::max(std::abs(double(start[c][i])), std::abs(double(state[c][i]))));
+            sum += (error / scale) * (error / scale);
+        }
+    }
+
+    return moving > 0 ? std::sqrt(sum / (6.0 * moving)) : 0.0;
+}
+
+/**
+ * moves the current state to the stage (the accepted 3rd order solution),
+ * its derivative becomes the first stage of the next step
+ * @param ParticleStore <Real>& current - state at the start of the step
+ */
+template <typename Real>
+void AdaptiveIntegrator<Real>::accept(ParticleStore <Real>& current) {
+    const ParticleStore <Real>& s = this->stage;
+
+    #pragma omp parallel for
+    for (int i = 0; i < current.size(); i++) {
+        current.px[i] = s.px[i]; current.py[i] = s.py[i]; current.pz[i] = s.pz[i];
+        current.vx[i] = s.vx[i]; current.vy[i] = s.vy[i]; current.vz[i] = s.vz[i];
+        current.ax[i] = s.ax[i]; current.ay[i] = s.ay[i]; current.az[i] = s.az[i];
+    }
+
+    this->storeDerivative(0, s);
+}
+
+/**
+ * advances the cube's particles by one frame with as many adaptive steps as the error needs,
+ * step sizes stay within [cube->adaptiveMinStep, cube->adaptiveMaxStep]
+ * a step at the minimum size is accepted whatever its error
+ * the accepted steps are recorded in cube->stepHistory
+ * @param Cube* cube - cube to integrate
+ * @param double frameTime - simulated time to advance
+ */
+template <typename Real>
+void AdaptiveIntegrator<Real>::advance(Cube* cube, double frameTime) {
+    // Bogacki-Shampine stages
+    const Real secondStage[3] = { Real(0.5), Real(0), Real(0) };
+    const Real thirdStage[3] = { Real(0), Real(0.75), Real(0) };
+    const Real solution[3] = { Real(2.0 / 9.0), Real(1.0 / 3.0), Real(4.0 / 9.0) };
+
+    ParticleStore <Real>& current = cube->getParticles<Real>();
+    StepHistory& history = cube->stepHistory;
+    const double minStep = double(cube->adaptiveMinStep);
+    const double maxStep = std::max(minStep, double(cube->adaptiveMaxStep));
+    const double tolerance = double(cube->adaptiveTolerance);
+    this->prepare(current);
+
+    history.accepted = 0;
+    history.rejected = 0;
+    if (this->nextStep <= 0.0) {
+        this->nextStep = maxStep;
+    }
+    this->nextStep = std::min(std::max(this->nextStep, minStep), maxStep);
+
+    // fixed points and forces may have changed since the last frame
+    computeAcceleration <Real>(cube, current, frameTime);
+    this->storeDerivative(0, current);
+
+    double remaining = frameTime;
+    while (remaining > 1e-9 * frameTime) {
+        // the last step of a frame is cut to end on the frame
+        const bool cut = this->nextStep >= remaining;
+        const double step = cut ? remaining : this->nextStep;
+        const Real dt = Real(step);
+
+        this->setStage(current, dt, secondStage);
+        computeAcceleration <Real>(cube, this->stage, step);
+        this->storeDerivative(1, this->stage);
+
+        this->setStage(current, dt, thirdStage);
+        computeAcceleration <Real>(cube, this->stage, step);
+        this->storeDerivative(2, this->stage);
+
+        this->setStage(current, dt, solution);
+        computeAcceleration <Real>(cube, this->stage, step);
+
+        const double error = this->errorNorm(current, dt, tolerance);
+        const double factor = error > 0.0 ? std::min(std::max(SAFETY * std::pow(error, -1.0 / 3.0), MIN_FACTOR), MAX_FACTOR) : MAX_FACTOR;
+        const double resized = std::min(std::max(step * factor, minStep), maxStep);
+
+        if (error <= 1.0 || step <= minStep) {
+            this->accept(current);
+            remaining -= step;
+            history.add(step);
+            history.accepted++;
+            // a cut step says nothing about the size the next one can take
+            if (!cut) {
+                this->nextStep = resized;
+            }
+        }
+        else {
+            history.rejected++;
+            this->nextStep = resized;
+        }
+    }
+}
+
+template class AdaptiveIntegrator <float>;
+template class AdaptiveIntegrator <double>;
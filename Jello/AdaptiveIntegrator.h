@@ -0,0 +1,52 @@
+#ifndef __ADAPTIVEINTEGRATOR_H__
+#define __ADAPTIVEINTEGRATOR_H__
+
+#include "ParticleStore.h"
+
+class Cube;
+
+// accepted step sizes of the adaptive integrator, shown in the ui
+struct StepHistory {
+    static const int SIZE = 128;
+    // ring of the last accepted step sizes, next is the oldest entry once it wrapped
+    float steps[SIZE] = {};
+    int next = 0;
+    // steps of the last frame
+    int accepted = 0;
+    int rejected = 0;
+
+    void add(double step) { steps[next] = float(step); next = (next + 1) % SIZE; }
+};
+
+// adaptive Runge-Kutta integrator, Bogacki-Shampine 3(2) embedded pair
+// the difference between the 3rd and 2nd order solution estimates the error of every step,
+// steps above the tolerance are redone smaller and the next step grows while the error stays small
+// the 4th stage is the 1st stage of the next step (first same as last), 3 force evaluations per accepted step
+// Real is the precision of the particles it integrates
+template <typename Real>
+class AdaptiveIntegrator {
+
+    public:
+        AdaptiveIntegrator() {}; // default constructor
+
+        void advance(Cube* cube, double frameTime);
+        void clear();
+
+    private:
+        // stage state and stage derivatives
+        ParticleBuffers buffers{};
+        // state the stage derivatives are evaluated at, holds the step result and its derivative after the 4th stage
+        ParticleStore <Real> stage{};
+        // derivatives (velocity, acceleration) of the first three stages
+        Real* k[3][6] = {};
+        // step size the next step tries, carried over between frames
+        double nextStep = 0.0;
+
+        void prepare(const ParticleStore <Real>& current);
+        void storeDerivative(int index, const ParticleStore <Real>& state);
+        void setStage(const ParticleStore <Real>& current, Real timeStep, const Real weights[3]);
+        double errorNorm(const ParticleStore <Real>& current, Real timeStep, double tolerance);
+        void accept(ParticleStore <Real>& current);
+};
+
+#endif
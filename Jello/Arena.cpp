@@ -0,0 +1,31 @@
+#include "Arena.h"
+
+Arena::~Arena() {
+    delete[] this->block;
+}
+
+void Arena::reserve(size_t bytes) {
+    this->offset = 0;
+
+    if (bytes <= this->size) {
+        // rebuild into the same block
+        return;
+    }
+
+    delete[] this->block;
+    this->block = new char[bytes];
+    this->size = bytes;
+}
+
+Arena& ParticleBuffers::resize(int count, int springs, size_t bytes) {
+    this->arena.reserve(bytes);
+    this->points = count;
+    this->springs = springs;
+    return this->arena;
+}
+
+void ParticleBuffers::clear() {
+    this->arena.reset();
+    this->points = 0;
+    this->springs = 0;
+}
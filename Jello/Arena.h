@@ -0,0 +1,87 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+// linear (bump) allocator backing the topology of a cube
+// everything built for one resolution lives in one block, reset releases all of it at once
+// and the next build reuses the same block, it is only replaced when a bigger one is needed
+// only meant for trivial types (no constructors or destructors are run)
+class Arena {
+
+    public:
+        Arena() {}; // default constructor
+        ~Arena();
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        // cache line, also covers AVX-512 loads
+        static const size_t ALIGNMENT = 64;
+
+        // makes sure the block holds at least bytes, only valid right after reset (drops all allocations)
+        void reserve(size_t bytes);
+        // releases every allocation, O(1)
+        void reset() { this->offset = 0; }
+
+        template <typename T>
+        T* allocate(size_t count);
+
+        // bytes one allocation of count T needs in the worst case (with alignment padding)
+        template <typename T>
+        static size_t bytesFor(size_t count) { return count * sizeof(T) + ALIGNMENT; }
+
+        size_t used() const { return this->offset; }
+        size_t capacity() const { return this->size; }
+
+    private:
+        char* block = nullptr;
+        size_t size = 0;
+        size_t offset = 0;
+};
+
+/**
+ * takes count elements of T from the block, aligned to ALIGNMENT
+ * @param size_t count - number of elements
+ * @return T* - uninitialized memory, nullptr if the block is too small
+ */
+template <typename T>
+T* Arena::allocate(size_t count) {
+    const uintptr_t base = reinterpret_cast<uintptr_t>(this->block);
+    const size_t start = ((base + this->offset + ALIGNMENT - 1) & ~uintptr_t(ALIGNMENT - 1)) - base;
+    const size_t end = start + count * sizeof(T);
+
+    if (end > this->size) {
+        std::cout << "ERROR::ARENA:: out of memory, reserve more before building" << std::endl;
+        return nullptr;
+    }
+
+    this->offset = end;
+    return reinterpret_cast<T*>(this->block + start);
+}
+
+// scratch buffers of a solver for one topology of a cube, laid out for its point and spring count
+// they are only laid out again when one of the counts changed, so a step does not allocate,
+// clear drops them and keeps the block for the next topology
+class ParticleBuffers {
+
+    public:
+        ParticleBuffers() {}; // default constructor
+
+        // whether the buffers are laid out for count points and springs
+        bool fits(int count, int springs = 0) const { return this->points == count && this->springs == springs; }
+        // drops the buffers and makes the block hold at least bytes, the new buffers are allocated from the result
+        Arena& resize(int count, int springs, size_t bytes);
+        void clear();
+
+        int pointCount() const { return this->points; }
+        int springCount() const { return this->springs; }
+
+    private:
+        Arena arena{};
+        int points = 0;
+        int springs = 0;
+};
+
+#endif
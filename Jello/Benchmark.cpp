@@ -0,0 +1,338 @@
+#include "Benchmark.h"
+#include "Physics.h"
+#include "Ensemble.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// set associative LRU cache, counts misses of a stream of byte addresses
+// portable stand-in for hardware counters, the same stream always gives the same rate
+class CacheModel {
+
+    public:
+        CacheModel(int sizeBytes, int ways) : ways(ways) {
+            this->sets = sizeBytes / (LINE * ways);
+            this->tags.assign(this->sets * ways, ~uint64_t(0));
+        }
+
+        static const int LINE = 64;
+
+        void access(const void* address) {
+            const uint64_t line = uint64_t(reinterpret_cast<uintptr_t>(address)) / LINE;
+            uint64_t* set = &this->tags[(line % this->sets) * this->ways];
+
+            this->accesses++;
+            // most recent first
+            int hit = this->ways - 1;
+            for (int w = 0; w < this->ways; w++) {
+                if (set[w] == line) {
+                    hit = w;
+                    break;
+                }
+            }
+            if (set[hit] != line) {
+                this->misses++;
+            }
+            for (int w = hit; w > 0; w--) {
+                set[w] = set[w - 1];
+            }
+            set[0] = line;
+        }
+
+        double missRate() const { return this->accesses > 0 ? double(this->misses) / double(this->accesses) : 0.0; }
+
+    private:
+        int sets = 1;
+        int ways = 1;
+        std::vector <uint64_t> tags{};
+        uint64_t accesses = 0;
+        uint64_t misses = 0;
+};
+
+static Cube* buildBenchmarkCube(int resolution, int order, int precision) {
+    Cube* cube = new Cube(resolution, glm::vec3(0.0f), 0, 0);
+    cube->particleOrder = order;
+    cube->precision = precision;
+    cube->setSpringMode(true, true, true);
+    return cube;
+}
+
+/**
+ * replays the particle reads and writes of the spring table pass through a cache model
+ * (single thread, springs in table order, every state array of both end points)
+ * @param Cube* cube - built cube
+ * @param int cacheBytes - modelled cache size
+ * @return double - fraction of accesses that miss
+ */
+template <typename Real>
+static double modelSpringPassMissRate(Cube* cube, int cacheBytes) {
+    const ParticleStore <Real>& p = cube->getParticles<Real>();
+    const SpringTable& springs = cube->springs;
+    const Real* arrays[9] = { p.px, p.py, p.pz, p.vx, p.vy, p.vz, p.ax, p.ay, p.az };
+
+    CacheModel cache(cacheBytes, 8);
+    for (int s = 0; s < springs.size(); s++) {
+        for (const Real* array : arrays) {
+            cache.access(array + springs.pointA[s]);
+            cache.access(array + springs.pointB[s]);
+        }
+    }
+
+    return cache.missRate();
+}
+
+/**
+ * average wall time of one Euler step
+ * @param Cube* cube - built cube
+ * @param int steps - timed steps, one untimed step warms up first
+ * @return double - milliseconds per step
+ */
+static double measureStepTime(Cube* cube, int steps) {
+    const double timeStep = 0.001;
+    integrateEuler(cube, timeStep);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++) {
+        integrateEuler(cube, timeStep);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration <double, std::milli>(end - start).count() / double(steps);
+}
+
+// L1 and L2 sized caches
+static const int L1_BYTES = 32 * 1024;
+static const int L2_BYTES = 1024 * 1024;
+
+static double modelSpringPassMissRate(Cube* cube, int cacheBytes) {
+    if (cube->getPrecision() == PRECISION_FLOAT) {
+        return modelSpringPassMissRate <float>(cube, cacheBytes);
+    }
+    return modelSpringPassMissRate <double>(cube, cacheBytes);
+}
+
+/**
+ * builds the cube and prints one row of miss rates and step times
+ * @param int resolution - points per side
+ * @param int order - particleOrderEnum
+ * @param int precision - precisionEnum
+ */
+static void benchmarkCube(int resolution, int order, int precision) {
+    const char* orderNames[2] = { "lattice", "morton" };
+    const char* precisionNames[2] = { "double", "float" };
+
+    const int pointCount = resolution * resolution * resolution;
+    // about the same amount of work per resolution
+    const int steps = std::max(3, (1 << 22) / pointCount);
+
+    Cube* cube = buildBenchmarkCube(resolution, order, precision);
+
+    const double l1Miss = modelSpringPassMissRate(cube, L1_BYTES);
+    const double l2Miss = modelSpringPassMissRate(cube, L2_BYTES);
+
+    cube->latticeGather = false;
+    const double tableTime = measureStepTime(cube, steps);
+    cube->reset();
+    cube->latticeGather = true;
+    const double gatherTime = measureStepTime(cube, steps);
+
+    std::printf("%5d %-8s %-7s %9.2f%% %9.2f%% %12.3f %12.3f\n", resolution, orderNames[order], precisionNames[precision],
+        100.0 * l1Miss, 100.0 * l2Miss, tableTime, gatherTime);
+    delete cube;
+}
+
+/**
+ * kinetic energy of the points plus potential energy of the springs
+ * @param Cube* cube - built cube
+ * @return double - total energy
+ */
+static double totalEnergy(Cube* cube) {
+    const SpringTable& springs = cube->springs;
+    double energy = 0.0;
+
+    for (int i = 0; i < cube->pointCount(); i++) {
+        energy += 0.5 * double(cube->mass) * glm::length2(cube->getVelocity(i));
+    }
+    for (int s = 0; s < springs.size(); s++) {
+        const double k = double(cube->stiffness) * double(cube->springTypeStiffness[springs.type[s]]);
+        const double stretch = glm::length(cube->getPosition(springs.pointA[s]) - cube->getPosition(springs.pointB[s])) - springs.restLength[s];
+        energy += 0.5 * k * stretch * stretch;
+    }
+
+    return energy;
+}
+
+typedef void (*integratorFunction)(Cube* cube, double timeStep);
+
+/**
+ * undamped cube floating inside the bounding box, starts breathing (velocity pointing away from its center)
+ * @param int resolution - points per side
+ * @param float stiffness - stiffness of the springs
+ * @return Cube* - cube ready to integrate
+ */
+static Cube* buildOscillatingCube(int resolution, float stiffness) {
+    Cube* cube = new Cube(resolution, glm::vec3(0.0f, 2.0f, 0.0f), 0, 0);
+    cube->stiffness = stiffness;
+    cube->damping = 0.0f;
+    cube->setSpringMode(true, true, true);
+
+    glm::dvec3 center = glm::dvec3(0.0);
+    for (int i = 0; i < cube->pointCount(); i++) {
+        center += cube->getPosition(i) / double(cube->pointCount());
+    }
+    for (int i = 0; i < cube->pointCount(); i++) {
+        cube->setVelocity(i, cube->getPosition(i) - center);
+    }
+    return cube;
+}
+
+/**
+ * relative change of the total energy of the oscillating cube after one simulated second
+ * @param integratorFunction integrate - integrator to run
+ * @param double timeStep - dt
+ * @param float stiffness - stiffness of the springs
+ * @return double - (E(1 s) - E(0)) / E(0), infinite or nan when the cube exploded
+ */
+static double measureEnergyDrift(integratorFunction integrate, double timeStep, float stiffness) {
+    Cube* cube = buildOscillatingCube(8, stiffness);
+    const double initialEnergy = totalEnergy(cube);
+
+    const int steps = int(1.0 / timeStep + 0.5);
+    for (int s = 0; s < steps; s++) {
+        integrate(cube, timeStep);
+    }
+    // position Verlet leaves the velocities to be derived
+    syncVelocity(cube);
+
+    const double drift = (totalEnergy(cube) - initialEnergy) / initialEnergy;
+    delete cube;
+    return drift;
+}
+
+/**
+ * average wall time of one step of an integrator
+ * @param integratorFunction integrate - integrator to run
+ * @param int resolution - points per side
+ * @param int steps - timed steps, one untimed step warms up first
+ * @return double - milliseconds per step
+ */
+static double measureIntegratorTime(integratorFunction integrate, int resolution, int steps) {
+    Cube* cube = buildBenchmarkCube(resolution, ORDER_LATTICE, PRECISION_DOUBLE);
+    const double timeStep = 0.001;
+    integrate(cube, timeStep);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++) {
+        integrate(cube, timeStep);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    delete cube;
+    return std::chrono::duration <double, std::milli>(end - start).count() / double(steps);
+}
+
+/**
+ * prints one energy drift column, anything past a hundred times the initial energy counts as exploded
+ * @param double drift - relative energy change
+ */
+static void printDrift(double drift) {
+    if (std::isfinite(drift) && std::abs(drift) < 100.0) {
+        std::printf(" %15.2f%%", 100.0 * drift);
+    }
+    else {
+        std::printf(" %16s", "diverged");
+    }
+}
+
+/**
+ * prints cost per step and energy drift of every integrator:
+ * drift of an undamped cube over one second at the default and at the top stiffness
+ * (bounded for the symplectic ones, growing without bound when a step size is unstable)
+ */
+static void benchmarkIntegrators() {
+    const char* names[5] = { "symplectic euler", "velocity verlet", "position verlet", "rk4", "implicit euler" };
+    const integratorFunction integrators[5] = { integrateEuler, integrateVelocityVerlet, integratePositionVerlet, integrateRK4, integrateImplicitEuler };
+    const int resolution = 32;
+    const int steps = 20;
+
+    std::printf("BENCHMARK::INTEGRATORS (res %d step time, res 8 energy drift after 1 s, undamped)\n", resolution);
+    std::printf("%-17s %10s %16s %16s %16s\n", "integrator", "step ms", "k 1500 dt .005", "k 2000 dt .01", "k 2000 dt 1/60");
+
+    for (int n = 0; n < 5; n++) {
+        const double time = measureIntegratorTime(integrators[n], resolution, steps);
+        std::printf("%-17s %10.3f", names[n], time);
+        printDrift(measureEnergyDrift(integrators[n], 0.005, 1500.0f));
+        printDrift(measureEnergyDrift(integrators[n], 0.01, 2000.0f));
+        printDrift(measureEnergyDrift(integrators[n], 1.0 / 60.0, 2000.0f));
+        std::printf("\n");
+    }
+}
+
+/**
+ * microseconds per step of one instance of an ensemble
+ * @param Cube* cube - cube with the topology
+ * @param int instances - ensemble size, stiffness swept from half to the full value across it
+ * @param int steps - timed steps
+ * @return double - microseconds per step and instance
+ */
+template <typename Real>
+static double measureEnsembleTime(Cube* cube, int instances, int steps) {
+    Ensemble <Real> ensemble(cube, instances);
+    for (int n = 0; n < instances; n++) {
+        const double sweep = 0.5 + 0.5 * double(n) / double(std::max(1, instances - 1));
+        ensemble.setParameters(n, cube->stiffness * sweep, cube->damping, cube->mass, 0.001);
+    }
+    ensemble.step();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++) {
+        ensemble.step();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration <double, std::micro>(end - start).count() / (double(steps) * double(instances));
+}
+
+/**
+ * cost of a parameter sweep: one cube per configuration against ensembles of growing size
+ * (the instances fill the vector lanes, so the cost per instance falls with the ensemble size)
+ */
+static void benchmarkEnsemble() {
+    const int resolution = 8;
+    const int steps = 200;
+    const int sizes[4] = { 1, 8, 32, 64 };
+
+    Cube* cube = buildBenchmarkCube(resolution, ORDER_LATTICE, PRECISION_DOUBLE);
+    const auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++) {
+        integrateEuler(cube, 0.001);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    std::printf("BENCHMARK::ENSEMBLE (res %d, us per instance step, single cube %.2f us)\n", resolution,
+        std::chrono::duration <double, std::micro>(end - start).count() / double(steps));
+    std::printf("%9s %10s %10s\n", "instances", "double", "float");
+    for (int instances : sizes) {
+        std::printf("%9d %10.2f %10.2f\n", instances, measureEnsembleTime <double>(cube, instances, steps),
+            measureEnsembleTime <float>(cube, instances, steps));
+    }
+    delete cube;
+}
+
+void runBenchmark() {
+    const int resolutions[3] = { 32, 64, 128 };
+
+    std::printf("BENCHMARK::PARTICLE ORDER AND PRECISION (%d threads)\n", omp_get_max_threads());
+    std::printf("%5s %-8s %-7s %10s %10s %12s %12s\n", "res", "order", "scalar", "L1 miss", "L2 miss", "table ms", "gather ms");
+
+    for (int resolution : resolutions) {
+        benchmarkCube(resolution, ORDER_LATTICE, PRECISION_DOUBLE);
+        benchmarkCube(resolution, ORDER_MORTON, PRECISION_DOUBLE);
+        benchmarkCube(resolution, ORDER_MORTON, PRECISION_FLOAT);
+    }
+
+    benchmarkIntegrators();
+    benchmarkEnsemble();
+}
@@ -0,0 +1,12 @@
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+// headless performance runs, started with the --benchmark command line flag
+// needs the OpenGL context (cubes create their buffers) and the global bounding box
+
+// particle order and precision: modelled cache miss rate of the spring pass and step time per resolution
+// integrators: step time and energy drift of an undamped cube
+// ensemble: cost per instance of a parameter sweep against one cube per configuration
+void runBenchmark();
+
+#endif
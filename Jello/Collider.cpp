@@ -0,0 +1,423 @@
+#include "Collider.h"
+#include "Physics.h"
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+// BOUNDS
+
+bool ColliderBounds::contains(const glm::dvec3& point) const {
+    return point.x >= min.x && point.x <= max.x
+        && point.y >= min.y && point.y <= max.y
+        && point.z >= min.z && point.z <= max.z;
+}
+
+bool ColliderBounds::overlaps(const ColliderBounds& other) const {
+    return min.x <= other.max.x && max.x >= other.min.x
+        && min.y <= other.max.y && max.y >= other.min.y
+        && min.z <= other.max.z && max.z >= other.min.z;
+}
+
+// SIGNED DISTANCE
+// every function returns the distance to the surface (negative inside) and writes the outward unit normal,
+// the closest point on the surface is point - distance * normal
+
+// direction of a vector, any unit vector when it has no length
+static glm::dvec3 direction(const glm::dvec3& v, double length) {
+    return length > 0.0 ? v / length : glm::dvec3(0.0, 1.0, 0.0);
+}
+
+static double signedDistance(const SphereCollider& sphere, const glm::dvec3& point, glm::dvec3& normal) {
+    const glm::dvec3 L = point - sphere.center;
+    const double length = glm::length(L);
+    normal = direction(L, length);
+    return length - sphere.radius;
+}
+
+static double signedDistance(const CapsuleCollider& capsule, const glm::dvec3& point, glm::dvec3& normal) {
+    // closest point on the segment
+    const glm::dvec3 ab = capsule.b - capsule.a;
+    const double length2 = glm::dot(ab, ab);
+    const double t = length2 > 0.0 ? glm::clamp(glm::dot(point - capsule.a, ab) / length2, 0.0, 1.0) : 0.0;
+
+    const glm::dvec3 L = point - (capsule.a + t * ab);
+    const double length = glm::length(L);
+    normal = direction(L, length);
+    return length - capsule.radius;
+}
+
+static double signedDistance(const BoxCollider& box, const glm::dvec3& point, glm::dvec3& normal) {
+    // into the box's frame, the rotation is orthonormal so its transpose is the inverse
+    const glm::dvec3 q = glm::transpose(box.rotation) * (point - box.center);
+    const glm::dvec3 d = glm::abs(q) - box.halfExtent;
+    const glm::dvec3 s = glm::dvec3(q.x < 0.0 ? -1.0 : 1.0, q.y < 0.0 ? -1.0 : 1.0, q.z < 0.0 ? -1.0 : 1.0);
+
+    const glm::dvec3 outside = glm::max(d, glm::dvec3(0.0));
+    const double outsideLength = glm::length(outside);
+    if (outsideLength > 0.0) {
+        // towards the closest face, edge or corner
+        normal = box.rotation * (outside * s / outsideLength);
+        return outsideLength;
+    }
+
+    // inside: out through the nearest face
+    int axis = 0;
+    if (d.y > d[axis]) axis = 1;
+    if (d.z > d[axis]) axis = 2;
+    glm::dvec3 local = glm::dvec3(0.0);
+    local[axis] = s[axis];
+    normal = box.rotation * local;
+    return d[axis];
+}
+
+static double signedDistance(const PlaneCollider& plane, const glm::dvec3& point, glm::dvec3& normal) {
+    normal = plane.normal;
+    return glm::dot(plane.normal, point) - plane.offset;
+}
+
+static double signedDistance(const GridCollider& grid, const glm::dvec3& point, glm::dvec3& normal) {
+    // cell and position inside it, points on the far faces use the last cell
+    const glm::dvec3 u = (point - grid.origin) / grid.cellSize;
+    const int i = glm::clamp(int(std::floor(u.x)), 0, grid.nx - 2);
+    const int j = glm::clamp(int(std::floor(u.y)), 0, grid.ny - 2);
+    const int k = glm::clamp(int(std::floor(u.z)), 0, grid.nz - 2);
+    const double fx = glm::clamp(u.x - i, 0.0, 1.0);
+    const double fy = glm::clamp(u.y - j, 0.0, 1.0);
+    const double fz = glm::clamp(u.z - k, 0.0, 1.0);
+
+    // corners of the cell
+    const size_t sy = size_t(grid.nx);
+    const size_t sz = size_t(grid.nx) * grid.ny;
+    const size_t base = size_t(i) + j * sy + k * sz;
+    const double c000 = grid.values[base], c100 = grid.values[base + 1];
+    const double c010 = grid.values[base + sy], c110 = grid.values[base + sy + 1];
+    const double c001 = grid.values[base + sz], c101 = grid.values[base + sz + 1];
+    const double c011 = grid.values[base + sy + sz], c111 = grid.values[base + sy + sz + 1];
+
+    // trilinear interpolation, x then y then z
+    const double c00 = c000 + fx * (c100 - c000);
+    const double c10 = c010 + fx * (c110 - c010);
+    const double c01 = c001 + fx * (c101 - c001);
+    const double c11 = c011 + fx * (c111 - c011);
+    const double c0 = c00 + fy * (c10 - c00);
+    const double c1 = c01 + fy * (c11 - c01);
+
+    // gradient of the same interpolation
+    const glm::dvec3 gradient = glm::dvec3(
+        (1.0 - fz) * ((1.0 - fy) * (c100 - c000) + fy * (c110 - c010)) + fz * ((1.0 - fy) * (c101 - c001) + fy * (c111 - c011)),
+        (1.0 - fz) * (c10 - c00) + fz * (c11 - c01),
+        c1 - c0);
+    normal = direction(gradient, glm::length(gradient));
+
+    return c0 + fz * (c1 - c0);
+}
+
+/**
+ * samples a signed distance function on a grid covering the region
+ * @param const glm::dvec3& minCorner, const glm::dvec3& maxCorner - region to bake
+ * @param double cellSize - distance between samples
+ * @param distance - signed distance function to sample
+ * @return GridCollider - the baked grid, its bounds are the sampled region
+ */
+GridCollider GridCollider::bake(const glm::dvec3& minCorner, const glm::dvec3& maxCorner, double cellSize,
+    const std::function<double(const glm::dvec3&)>& distance) {
+    GridCollider grid;
+    grid.origin = minCorner;
+    grid.cellSize = cellSize;
+
+    // at least one cell per axis
+    const glm::dvec3 extent = maxCorner - minCorner;
+    grid.nx = std::max(2, int(std::ceil(extent.x / cellSize)) + 1);
+    grid.ny = std::max(2, int(std::ceil(extent.y / cellSize)) + 1);
+    grid.nz = std::max(2, int(std::ceil(extent.z / cellSize)) + 1);
+    grid.values.resize(size_t(grid.nx) * grid.ny * grid.nz);
+
+    #pragma omp parallel for
+    for (int k = 0; k < grid.nz; k++) {
+        for (int j = 0; j < grid.ny; j++) {
+            for (int i = 0; i < grid.nx; i++) {
+                const glm::dvec3 sample = minCorner + cellSize * glm::dvec3(i, j, k);
+                grid.values[i + size_t(grid.nx) * (j + size_t(grid.ny) * k)] = float(distance(sample));
+            }
+        }
+    }
+
+    grid.bounds.min = minCorner;
+    grid.bounds.max = minCorner + cellSize * glm::dvec3(grid.nx - 1, grid.ny - 1, grid.nz - 1);
+    return grid;
+}
+
+// SET
+
+void ColliderSet::addSphere(const glm::dvec3& center, double radius) {
+    const glm::dvec3 r = glm::dvec3(radius);
+    this->spheres.push_back({ center, radius, { center - r, center + r } });
+}
+
+void ColliderSet::addCapsule(const glm::dvec3& a, const glm::dvec3& b, double radius) {
+    const glm::dvec3 r = glm::dvec3(radius);
+    this->capsules.push_back({ a, b, radius, { glm::min(a, b) - r, glm::max(a, b) + r } });
+}
+
+void ColliderSet::addBox(const glm::dvec3& center, const glm::dvec3& halfExtent, const glm::dmat3& rotation) {
+    // extent of the rotated box along the world axes: |R| * h
+    glm::dmat3 absolute;
+    for (int c = 0; c < 3; c++) {
+        absolute[c] = glm::abs(rotation[c]);
+    }
+    const glm::dvec3 r = absolute * halfExtent;
+    this->boxes.push_back({ center, halfExtent, rotation, { center - r, center + r } });
+}
+
+void ColliderSet::addPlane(const glm::dvec3& normal, const glm::dvec3& pointInPlane) {
+    // a half space is unbounded
+    const double infinity = std::numeric_limits<double>::infinity();
+    const glm::dvec3 n = glm::normalize(normal);
+    this->planes.push_back({ n, glm::dot(n, pointInPlane), { glm::dvec3(-infinity), glm::dvec3(infinity) } });
+}
+
+void ColliderSet::addGrid(GridCollider grid) {
+    this->grids.push_back(std::move(grid));
+}
+
+void ColliderSet::clear() {
+    this->spheres.clear();
+    this->capsules.clear();
+    this->boxes.clear();
+    this->planes.clear();
+    this->grids.clear();
+    this->contactCount = 0;
+}
+
+bool ColliderSet::empty() const {
+    return this->spheres.empty() && this->capsules.empty() && this->boxes.empty() && this->planes.empty() && this->grids.empty();
+}
+
+// distance to the closest collider of one type, keeps the normal of the closest
+template <typename Shape>
+static void closest(const std::vector <Shape>& shapes, const glm::dvec3& point, double& distance, glm::dvec3& normal) {
+    for (const Shape& shape : shapes) {
+        glm::dvec3 n;
+        const double d = signedDistance(shape, point, n);
+        if (d < distance) {
+            distance = d;
+            normal = n;
+        }
+    }
+}
+
+/**
+ * signed distance to the union of every collider (the grids only inside their region)
+ * @param const glm::dvec3& point - query point
+ * @param glm::dvec3& normal - outward normal of the closest collider
+ * @return double - signed distance, infinity without colliders
+ */
+double ColliderSet::distance(const glm::dvec3& point, glm::dvec3& normal) const {
+    double distance = std::numeric_limits<double>::infinity();
+    normal = glm::dvec3(0.0, 1.0, 0.0);
+
+    closest(this->spheres, point, distance, normal);
+    closest(this->capsules, point, distance, normal);
+    closest(this->boxes, point, distance, normal);
+    closest(this->planes, point, distance, normal);
+    for (const GridCollider& grid : this->grids) {
+        glm::dvec3 n;
+        const double d = grid.bounds.contains(point) ? signedDistance(grid, point, n) : std::numeric_limits<double>::infinity();
+        if (d < distance) {
+            distance = d;
+            normal = n;
+        }
+    }
+    return distance;
+}
+
+// SWEEP
+
+// distance (m) to a collider at which a swept point counts as touching it, and steps before the sweep gives up
+static const double SWEEP_TOLERANCE = 1e-6;
+static const int SWEEP_ITERATIONS = 32;
+
+/**
+ * distance the sweep can move a point without reaching a collider: the signed distance, except that outside
+ * its region a grid counts as far as its bounds (plus the tolerance, so the next step lands inside them)
+ * @param const glm::dvec3& point - query point
+ * @param glm::dvec3& normal - outward normal of the closest collider
+ * @return double - distance, infinity without colliders
+ */
+double ColliderSet::sweepDistance(const glm::dvec3& point, glm::dvec3& normal) const {
+    double distance = std::numeric_limits<double>::infinity();
+    normal = glm::dvec3(0.0, 1.0, 0.0);
+
+    closest(this->spheres, point, distance, normal);
+    closest(this->capsules, point, distance, normal);
+    closest(this->boxes, point, distance, normal);
+    closest(this->planes, point, distance, normal);
+    for (const GridCollider& grid : this->grids) {
+        glm::dvec3 n = normal;
+        const double d = grid.bounds.contains(point) ? signedDistance(grid, point, n)
+            : glm::length(glm::max(glm::max(grid.bounds.min - point, point - grid.bounds.max), glm::dvec3(0.0))) + SWEEP_TOLERANCE;
+        if (d < distance) {
+            distance = d;
+            normal = n;
+        }
+    }
+    return distance;
+}
+
+/**
+ * time of impact of a point moving on a straight line, by conservative advancement: the point moves on by its
+ * distance to the colliders (no collider is closer) until it is within the tolerance of one, a line that grazes
+ * a collider without converging in SWEEP_ITERATIONS stops where it got to, which is still outside
+ * a point that starts inside a collider has no impact, the penalty response pushes it out, one that starts on
+ * its surface only when the line goes into it
+ * @param const glm::dvec3& from, const glm::dvec3& to - start and end of the line
+ * @param glm::dvec3& normal - outward normal at the impact
+ * @return double - fraction of the line at the impact, larger than 1 without one
+ */
+double ColliderSet::sweep(const glm::dvec3& from, const glm::dvec3& to, glm::dvec3& normal) const {
+    const double length = glm::length(to - from);
+    double d = this->sweepDistance(from, normal);
+    if (d <= 0.0 || d >= length) {
+        return 2.0;
+    }
+    if (d < SWEEP_TOLERANCE) {
+        // resting on a collider (a point that hit it before), only a line into it is an impact
+        return glm::dot(to - from, normal) < 0.0 ? 0.0 : 2.0;
+    }
+
+    double t = 0.0;
+    for (int k = 0; k < SWEEP_ITERATIONS; k++) {
+        t += d / length;
+        if (t > 1.0) {
+            return 2.0;
+        }
+        d = this->sweepDistance(from + t * (to - from), normal);
+        if (d < SWEEP_TOLERANCE) {
+            return t;
+        }
+    }
+    return t;
+}
+
+// QUERY
+
+// whether a collider of one type overlaps the particles
+template <typename Shape>
+static bool overlaps(const std::vector <Shape>& shapes, const ColliderBounds& particleBounds) {
+    for (const Shape& shape : shapes) {
+        if (shape.bounds.overlaps(particleBounds)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// contacts of one point with every collider of one type, f(closestPoint) for every collider it is inside
+// (a collider whose bounds miss the point is out after one test)
+template <typename Shape, typename F>
+static bool collide(const std::vector <Shape>& shapes, const glm::dvec3& position, const F& f) {
+    bool touching = false;
+    for (const Shape& shape : shapes) {
+        if (!shape.bounds.contains(position)) {
+            continue;
+        }
+        glm::dvec3 normal;
+        const double d = signedDistance(shape, position, normal);
+        if (d < 0.0) {
+            f(position - d * normal);
+            touching = true;
+        }
+    }
+    return touching;
+}
+
+/**
+ * calls f(i, closestPoint) for every particle inside a collider, in parallel over the particles
+ * (all contacts of a particle are found by the same thread, in the same order)
+ * @param const ParticleStore <Real>& particles - particles to test
+ * @param const F& f - contact callback
+ */
+template <typename Real, typename F>
+void ColliderSet::forEachContact(const ParticleStore <Real>& particles, const F& f) const {
+    if (this->empty() || particles.size() == 0) {
+        this->contactCount = 0;
+        return;
+    }
+
+    // bounds of the particles, colliders that miss them are out for the whole query
+    ColliderBounds particleBounds{ glm::dvec3(particles.getPosition(0)), glm::dvec3(particles.getPosition(0)) };
+    for (int i = 1; i < particles.size(); i++) {
+        const glm::dvec3 position = glm::dvec3(particles.getPosition(i));
+        particleBounds.min = glm::min(particleBounds.min, position);
+        particleBounds.max = glm::max(particleBounds.max, position);
+    }
+
+    int contacts = 0;
+    if (overlaps(this->spheres, particleBounds) || overlaps(this->capsules, particleBounds) || overlaps(this->boxes, particleBounds)
+        || overlaps(this->planes, particleBounds) || overlaps(this->grids, particleBounds)) {
+        #pragma omp parallel for reduction(+:contacts)
+        for (int i = 0; i < particles.size(); i++) {
+            const glm::dvec3 position = glm::dvec3(particles.getPosition(i));
+            const auto contact = [&](const glm::dvec3& closestPoint) { f(i, closestPoint); };
+
+            bool touching = collide(this->spheres, position, contact);
+            touching |= collide(this->capsules, position, contact);
+            touching |= collide(this->boxes, position, contact);
+            touching |= collide(this->planes, position, contact);
+            touching |= collide(this->grids, position, contact);
+            contacts += touching ? 1 : 0;
+        }
+    }
+    this->contactCount = contacts;
+}
+
+/**
+ * penalty response of every penetrating particle, a rest length 0 spring towards the closest surface point
+ * with the damping of processCollisionResponse (applied once per collider the particle is inside)
+ * @param Cube* const cube - cube with stiffness, damping and mass
+ * @param ParticleStore <Real>& particles - particle state to read and accumulate into
+ */
+template <typename Real>
+void ColliderSet::addContactAcceleration(Cube* const cube, ParticleStore <Real>& particles) const {
+    this->forEachContact(particles, [&](int i, const glm::dvec3& closestPoint) {
+        processCollisionResponse <Real>(cube, particles, i, closestPoint);
+    });
+}
+
+/**
+ * penalty response of a single point, the acceleration addContactAcceleration gives it
+ * @param Cube* const cube - cube with stiffness, damping and mass
+ * @param const glm::dvec3& position, const glm::dvec3& velocity - state of the point
+ * @return glm::dvec3 - contact acceleration, 0 outside every collider
+ */
+glm::dvec3 ColliderSet::contactAcceleration(Cube* const cube, const glm::dvec3& position, const glm::dvec3& velocity) const {
+    glm::dvec3 acceleration = glm::dvec3(0.0);
+    const auto contact = [&](const glm::dvec3& closestPoint) {
+        acceleration += ::contactAcceleration(cube, position, velocity, closestPoint);
+    };
+    collide(this->spheres, position, contact);
+    collide(this->capsules, position, contact);
+    collide(this->boxes, position, contact);
+    collide(this->planes, position, contact);
+    collide(this->grids, position, contact);
+    return acceleration;
+}
+
+/**
+ * projection response, every free penetrating particle moves to the closest surface point
+ * (a particle inside two colliders at once ends on the surface of the last one)
+ * @param ParticleStore <Real>& particles - particle positions to correct
+ */
+template <typename Real>
+void ColliderSet::project(ParticleStore <Real>& particles) const {
+    this->forEachContact(particles, [&](int i, const glm::dvec3& closestPoint) {
+        if (!particles.isFixed(i)) {
+            particles.setPosition(i, glm::vec<3, Real>(closestPoint));
+        }
+    });
+}
+
+template void ColliderSet::addContactAcceleration <float>(Cube* const cube, ParticleStore <float>& particles) const;
+template void ColliderSet::addContactAcceleration <double>(Cube* const cube, ParticleStore <double>& particles) const;
+template void ColliderSet::project <float>(ParticleStore <float>& particles) const;
+template void ColliderSet::project <double>(ParticleStore <double>& particles) const;
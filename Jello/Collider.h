@@ -0,0 +1,115 @@
+#ifndef __COLLIDER_H__
+#define __COLLIDER_H__
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <functional>
+
+#include "ParticleStore.h"
+
+class Cube;
+
+// obstacles inside the bounding box, described by signed distance functions (negative inside the solid)
+// every shape type lives in its own array and is queried by its own loop, there is no virtual dispatch per particle
+// every collider caches an axis aligned bounding volume: colliders whose volume misses the cube are skipped
+// for the whole step, and particles outside the volume of a collider never evaluate its distance
+
+// axis aligned bounding volume
+struct ColliderBounds {
+    glm::dvec3 min = glm::dvec3(0.0);
+    glm::dvec3 max = glm::dvec3(0.0);
+
+    bool contains(const glm::dvec3& point) const;
+    bool overlaps(const ColliderBounds& other) const;
+};
+
+struct SphereCollider {
+    glm::dvec3 center;
+    double radius;
+    ColliderBounds bounds;
+};
+
+// every point within radius of the segment a - b
+struct CapsuleCollider {
+    glm::dvec3 a, b;
+    double radius;
+    ColliderBounds bounds;
+};
+
+// oriented box, rotation holds the local axes as columns
+struct BoxCollider {
+    glm::dvec3 center;
+    glm::dvec3 halfExtent;
+    glm::dmat3 rotation;
+    ColliderBounds bounds;
+};
+
+// half space below the plane, the normal points out of the solid
+struct PlaneCollider {
+    glm::dvec3 normal;
+    double offset;
+    ColliderBounds bounds;
+};
+
+// signed distance sampled on a regular grid, trilinear lookup (the normal is the gradient of the interpolation)
+// nothing outside the grid collides, so the baked region has to enclose the solid with a margin of a cell
+struct GridCollider {
+    glm::dvec3 origin = glm::dvec3(0.0);
+    double cellSize = 1.0;
+    int nx = 0, ny = 0, nz = 0;
+    // x fastest, then y, then z
+    std::vector <float> values{};
+    ColliderBounds bounds;
+
+    static GridCollider bake(const glm::dvec3& minCorner, const glm::dvec3& maxCorner, double cellSize,
+        const std::function<double(const glm::dvec3&)>& distance);
+};
+
+class ColliderSet {
+
+    public:
+        ColliderSet() {}; // default constructor
+
+        // setup
+        void addSphere(const glm::dvec3& center, double radius);
+        void addCapsule(const glm::dvec3& a, const glm::dvec3& b, double radius);
+        void addBox(const glm::dvec3& center, const glm::dvec3& halfExtent, const glm::dmat3& rotation = glm::dmat3(1.0));
+        void addPlane(const glm::dvec3& normal, const glm::dvec3& pointInPlane);
+        void addGrid(GridCollider grid);
+        void clear();
+        bool empty() const;
+
+        // signed distance to the union of all colliders, and its normal
+        double distance(const glm::dvec3& point, glm::dvec3& normal) const;
+        // time of impact of a point moving on a straight line (fraction of the line, larger than 1 without one)
+        // and the outward normal there
+        double sweep(const glm::dvec3& from, const glm::dvec3& to, glm::dvec3& normal) const;
+
+        // penalty response: every penetrating particle gets the collision response of processCollisionResponse
+        // towards the closest point on the surface, one per collider it is inside
+        template <typename Real>
+        void addContactAcceleration(Cube* const cube, ParticleStore <Real>& particles) const;
+        // the same response for a single point (not counted in the contacts)
+        glm::dvec3 contactAcceleration(Cube* const cube, const glm::dvec3& position, const glm::dvec3& velocity) const;
+        // projection response for the position based solvers: free penetrating particles move onto the surface
+        template <typename Real>
+        void project(ParticleStore <Real>& particles) const;
+
+        // penetrating particles found by the last query
+        int getContactCount() const { return this->contactCount; }
+
+    private:
+        std::vector <SphereCollider> spheres{};
+        std::vector <CapsuleCollider> capsules{};
+        std::vector <BoxCollider> boxes{};
+        std::vector <PlaneCollider> planes{};
+        std::vector <GridCollider> grids{};
+
+        mutable int contactCount = 0;
+
+        template <typename Real, typename F>
+        void forEachContact(const ParticleStore <Real>& particles, const F& f) const;
+        double sweepDistance(const glm::dvec3& point, glm::dvec3& normal) const;
+};
+
+#endif
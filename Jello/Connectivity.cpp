@@ -0,0 +1,47 @@
+#include "Connectivity.h"
+
+// arena bytes for the rows of pointCount points with linkCount links in total
+size_t Connectivity::bytesFor(int pointCount, int linkCount) {
+    return Arena::bytesFor<uint32_t>(pointCount + 1) + Arena::bytesFor<uint32_t>(linkCount);
+}
+
+/**
+ * fills the rows from the spring table, spring a - b becomes link b of point a
+ * counting pass, prefix sum, then one fill pass, no per point allocation
+ * @param Arena& arena - arena with at least bytesFor(pointCount, springs.size()) left
+ * @param const SpringTable& springs - every spring of the cube
+ * @param int pointCount - number of points
+ */
+void Connectivity::build(Arena& arena, const SpringTable& springs, int pointCount) {
+    this->count = pointCount;
+    this->offsets = arena.allocate<uint32_t>(pointCount + 1);
+    this->links = arena.allocate<uint32_t>(springs.size());
+
+    // links per point, shifted by one for the prefix sum
+    for (int p = 0; p <= pointCount; p++) {
+        this->offsets[p] = 0;
+    }
+    for (int s = 0; s < springs.size(); s++) {
+        this->offsets[springs.pointA[s] + 1]++;
+    }
+    for (int p = 0; p < pointCount; p++) {
+        this->offsets[p + 1] += this->offsets[p];
+    }
+
+    // fill, offsets[p] is the next free slot of point p and ends at the start of point p + 1
+    for (int s = 0; s < springs.size(); s++) {
+        this->links[this->offsets[springs.pointA[s]]++] = uint32_t(springs.pointB[s]);
+    }
+    // shift back so offsets[p] is the start of point p again
+    for (int p = pointCount; p > 0; p--) {
+        this->offsets[p] = this->offsets[p - 1];
+    }
+    this->offsets[0] = 0;
+}
+
+// forgets the rows, the arena they came from releases the memory
+void Connectivity::clear() {
+    this->count = 0;
+    this->offsets = nullptr;
+    this->links = nullptr;
+}
@@ -0,0 +1,48 @@
+#ifndef __CONNECTIVITY_H__
+#define __CONNECTIVITY_H__
+
+#include <cstdint>
+
+#include "Arena.h"
+#include "SpringTable.h"
+
+// connected points of every point in compressed sparse rows (CSR), shared by the whole cube
+// neighbors of point p are links[offsets[p]] .. links[offsets[p + 1] - 1], every spring appears once
+// (at the point that created it), arrays live in the cube's topology arena
+class Connectivity {
+
+    public:
+        Connectivity() {}; // default constructor
+        // copies would alias the same arena memory
+        Connectivity(const Connectivity&) = delete;
+        Connectivity& operator=(const Connectivity&) = delete;
+
+        // neighbors of one point, usable in a range based for loop
+        class Range {
+            public:
+                Range(const uint32_t* first, const uint32_t* last) : first(first), last(last) {}
+                const uint32_t* begin() const { return this->first; }
+                const uint32_t* end() const { return this->last; }
+                int size() const { return int(this->last - this->first); }
+
+            private:
+                const uint32_t* first;
+                const uint32_t* last;
+        };
+
+        // setup
+        static size_t bytesFor(int pointCount, int linkCount);
+        void build(Arena& arena, const SpringTable& springs, int pointCount);
+        void clear();
+
+        Range neighbors(int point) const { return Range(this->links + this->offsets[point], this->links + this->offsets[point + 1]); }
+        int pointCount() const { return this->count; }
+        int linkCount() const { return this->count > 0 ? int(this->offsets[this->count]) : 0; }
+
+    private:
+        int count = 0;
+        uint32_t* offsets = nullptr;
+        uint32_t* links = nullptr;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #include "Cube.h"
 
 #include <iostream>
+#include <algorithm>
 
 Cube::Cube(int resolution, glm::vec3 position, GLint shader, GLint debug) {
     this->resolution = resolution;
@@ -20,14 +21,66 @@ Cube::Cube() {
     initArrays();
 }
 
+// releases the vertex array and buffers of initArrays, the particles and springs free themselves
+Cube::~Cube() {
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &texVBO);
+    glDeleteBuffers(1, &normalVBO);
+}
+
 void Cube::reset() {
     setSpringMode(this->structuralSpring, this->shearSpring, this->bendSpring);
 }
 
-void Cube::addConnection(MassPoint **** massPointMap, MassPoint* point, int i, int j, int k) {
+int Cube::pointIndex(int i, int j, int k) const {
+    // points are filled along the x axis first, then z then y 
+    const int latticeIndex = (j * this->resolution + k) * this->resolution + i;
+    // reordered particles are looked up
+    return this->latticeToParticle != nullptr ? this->latticeToParticle[latticeIndex] : latticeIndex;
+}
+
+// keeps every third bit of v (0, 3, 6, ...) and packs them together, inverse of interleaving
+static uint32_t compactBits(uint32_t v) {
+    v &= 0x09249249;
+    v = (v | (v >> 2)) & 0x030c30c3;
+    v = (v | (v >> 4)) & 0x0300f00f;
+    v = (v | (v >> 8)) & 0x030000ff;
+    v = (v | (v >> 16)) & 0x000003ff;
+    return v;
+}
+
+/**
+ * numbers the lattice points along the morton (z-order) curve, codes interleave the bits of i, k and j
+ * walks every code of the enclosing power of two cube in order and skips the ones outside the lattice
+ * @param int resolution - points per side, at most 1024
+ * @param int* latticeToParticle - output, particle index of every lattice index
+ */
+static void buildMortonOrder(int resolution, int* latticeToParticle) {
+    uint32_t side = 1;
+    while (side < uint32_t(resolution)) {
+        side <<= 1;
+    }
+
+    int rank = 0;
+    for (uint32_t code = 0; code < side * side * side; code++) {
+        const int i = int(compactBits(code));
+        const int k = int(compactBits(code >> 1));
+        const int j = int(compactBits(code >> 2));
+        if (i < resolution && j < resolution && k < resolution) {
+            latticeToParticle[(j * resolution + k) * resolution + i] = rank++;
+        }
+    }
+}
+
+void Cube::addConnection(int point, int i, int j, int k, springTypeEnum type) {
     // for surface nodes, some neighbors might not exists
     if (i < resolution && j < resolution && k < resolution && i >= 0 && j >= 0 && k >= 0) {
-        point->addConnection(massPointMap[i][j][k]);
+        const int neighbor = pointIndex(i, j, k);
+
+        // rest length only depends on the initial positions, compute it once here
+        const double restLength = glm::length(this->getInitialPosition(point) - this->getInitialPosition(neighbor));
+        this->springs.addSpring(point, neighbor, restLength, type);
     }
 }
 
@@ -35,18 +88,33 @@ void Cube::fillDiscretePoints(bool structural, bool shear, bool bend) {
 
     const int maxRes = this->resolution > 1 ? this->resolution - 1 : 1;
 
-    // create a storage space to store the points
-    MassPoint**** massPointMap = new MassPoint * **[this->resolution];
-    // make 3d array to store relationship massPoints
-    for (int i = 0; i < this->resolution; ++i) {
-        massPointMap[i] = new MassPoint * *[this->resolution];
-        for (int j = 0; j < this->resolution; ++j) {
-            massPointMap[i][j] = new MassPoint * [this->resolution];
-            for (int k = 0; k < this->resolution; ++k) {
-                massPointMap[i][j][k] = new MassPoint[this->resolution];
-            }
-        }
+    // one slot per point, indexed with pointIndex(i, j, k)
+    const int pointCount = this->resolution * this->resolution * this->resolution;
+    // upper bound of springs per point, surface points have fewer
+    const int springsPerPoint = (structural ? 3 : 0) + (shear ? 10 : 0) + (bend ? 3 : 0);
+    const int springCount = pointCount * springsPerPoint;
+
+    // one block for the whole topology, reused as long as it is big enough
+    const size_t particleBytes = this->precision == PRECISION_FLOAT ? ParticleStore <float>::bytesFor(pointCount) : ParticleStore <double>::bytesFor(pointCount);
+    this->topology.reserve(particleBytes + SpringTable::bytesFor(springCount)
+        + Connectivity::bytesFor(pointCount, springCount) + Arena::bytesFor<int>(pointCount));
+
+    // slot of every lattice point in the particle store, everything below goes through pointIndex
+    this->latticeToParticle = nullptr;
+    if (this->particleOrder == ORDER_MORTON) {
+        this->latticeToParticle = this->topology.allocate<int>(pointCount);
+        buildMortonOrder(this->resolution, this->latticeToParticle);
+    }
+
+    // only the store of the chosen precision is filled
+    this->builtPrecision = this->precision;
+    if (this->builtPrecision == PRECISION_FLOAT) {
+        this->particlesFloat.allocate(this->topology, pointCount);
+    }
+    else {
+        this->particles.allocate(this->topology, pointCount);
     }
+    this->springs.allocate(this->topology, springCount);
 
     // fill points
     for (int j = 0; j < this->resolution; j++) {
@@ -77,8 +145,15 @@ void Cube::fillDiscretePoints(bool structural, bool shear, bool bend) {
                 */
                 bool isSurface = i * j * k * (maxRes - i) * (maxRes - j) * (maxRes - k) == 0;
                 
-                // store pointers
-                MassPoint* point = new MassPoint(glm::vec3(float(i) / float(maxRes), float(j) / float(maxRes), float(k) / float(maxRes)), isSurface);
+                // store point
+                const int point = pointIndex(i, j, k);
+                const glm::vec3 initPosition = this->latticeOrigin + glm::vec3(float(i) / float(maxRes), float(j) / float(maxRes), float(k) / float(maxRes));
+                if (this->builtPrecision == PRECISION_FLOAT) {
+                    this->particlesFloat.initPoint(point, initPosition, isSurface);
+                }
+                else {
+                    this->particles.initPoint(point, initPosition, isSurface);
+                }
                 
                 // get sides
                 if (isSurface) {
@@ -95,7 +170,12 @@ void Cube::fillDiscretePoints(bool structural, bool shear, bool bend) {
                     if (j == 0) {
                         // bottom
                         if (this->fixedFloor) {
-                            point->setFixed(true);
+                            if (this->builtPrecision == PRECISION_FLOAT) {
+                                this->particlesFloat.setFixed(point, true);
+                            }
+                            else {
+                                this->particles.setFixed(point, true);
+                            }
                         }
                         bottomFace.push_back(point);
                     }
@@ -112,9 +192,6 @@ void Cube::fillDiscretePoints(bool structural, bool shear, bool bend) {
                         frontFace.push_back(point);
                     }
                 }
-                
-                discretePoints.push_back(point);
-                massPointMap[i][j][k] = point;
             }
         }
     }
@@ -123,33 +200,33 @@ void Cube::fillDiscretePoints(bool structural, bool shear, bool bend) {
     for (int i = 0; i < this->resolution; i++) {
         for (int j = 0; j < this->resolution; j++) {
             for (int k = 0; k < this->resolution; k++) {
-                MassPoint* point = massPointMap[i][j][k];
+                const int point = pointIndex(i, j, k);
 
                 if (structural) {
                     /* Node(i, j, k) connected to
                         (i + 1, j, k), (i - 1, j, k), (i, j - 1, k), 
                         (i, j + 1, k), (i, j, k - 1), (i, j, k + 1)
                     */
-                    addConnection(massPointMap, point, i + 1, j, k);
-                    addConnection(massPointMap, point, i, j + 1, k);
-                    addConnection(massPointMap, point, i, j, k + 1);
+                    addConnection(point, i + 1, j, k, STRUCTURAL);
+                    addConnection(point, i, j + 1, k, STRUCTURAL);
+                    addConnection(point, i, j, k + 1, STRUCTURAL);
                 }
 
                 if (shear) {
                     // Every node connected to its diagonal neighbors
 
-                    addConnection(massPointMap, point, i + 1, j + 1, k);
-                    addConnection(massPointMap, point, i - 1, j + 1, k);
-                    addConnection(massPointMap, point, i, j + 1, k + 1);
+                    addConnection(point, i + 1, j + 1, k, SHEAR);
+                    addConnection(point, i - 1, j + 1, k, SHEAR);
+                    addConnection(point, i, j + 1, k + 1, SHEAR);
 
-                    addConnection(massPointMap, point, i, j - 1, k + 1);
-                    addConnection(massPointMap, point, i + 1, j, k + 1);
-                    addConnection(massPointMap, point, i - 1, j, k + 1);
+                    addConnection(point, i, j - 1, k + 1, SHEAR);
+                    addConnection(point, i + 1, j, k + 1, SHEAR);
+                    addConnection(point, i - 1, j, k + 1, SHEAR);
 
-                    addConnection(massPointMap, point, i + 1, j + 1, k + 1);
-                    addConnection(massPointMap, point, i - 1, j + 1, k + 1);
-                    addConnection(massPointMap, point, i - 1, j - 1, k + 1);
-                    addConnection(massPointMap, point, i + 1, j - 1, k + 1);
+                    addConnection(point, i + 1, j + 1, k + 1, SHEAR);
+                    addConnection(point, i - 1, j + 1, k + 1, SHEAR);
+                    addConnection(point, i - 1, j - 1, k + 1, SHEAR);
+                    addConnection(point, i + 1, j - 1, k + 1, SHEAR);
                 }
 
                 if (bend) {
@@ -157,50 +234,120 @@ void Cube::fillDiscretePoints(bool structural, bool shear, bool bend) {
                     // (6 connections per node, unless surface node)
                     // only adding the positive ones to itself
 
-                    addConnection(massPointMap, point, i + 2, j, k);
-                    addConnection(massPointMap, point, i, j + 2, k);
-                    addConnection(massPointMap, point, i, j, k + 2);
+                    addConnection(point, i + 2, j, k, BEND);
+                    addConnection(point, i, j + 2, k, BEND);
+                    addConnection(point, i, j, k + 2, BEND);
                 }
 
             }
         }
     }
-    
+
+    // rows of connected points, read by render
+    this->connections.build(this->topology, this->springs, pointCount);
+
+    // group springs into batches that do not share points for the parallel force pass
+    // bricks have to be at least 2 points wide since springs reach 2 points away
+    const int brickSize = std::max(2, std::min(8, this->resolution / 4));
+    const int bricksPerSide = (this->resolution + brickSize - 1) / brickSize;
+    std::vector <int> pointBrick(pointCount);
+    for (int j = 0; j < this->resolution; j++) {
+        for (int k = 0; k < this->resolution; k++) {
+            for (int i = 0; i < this->resolution; i++) {
+                pointBrick[pointIndex(i, j, k)] = ((j / brickSize) * bricksPerSide + k / brickSize) * bricksPerSide + i / brickSize;
+            }
+        }
+    }
+    this->springs.buildBatches(pointBrick, bricksPerSide);
+
+    // same springs as implicit offsets for the gather force pass
+    this->stencil.build(this->resolution, structural, shear, bend);
 }
 
 
 void Cube::resetAcceleration() {
     // reset acceleration for all points
-    for (int i = 0; i < discretePoints.size(); i++) {
-        MassPoint* currentPoint = discretePoints[i];
-        currentPoint->setAcceleration(glm::dvec3(0));
+    if (this->builtPrecision == PRECISION_FLOAT) {
+        this->particlesFloat.resetAcceleration();
+    }
+    else {
+        this->particles.resetAcceleration();
     }
 }
 
-void Cube::setExternalForce(glm::dvec3 force) {
-    for (int i = 0; i < discretePoints.size(); i++) {
-        MassPoint* currentPoint = discretePoints[i];
+int Cube::pointCount() const {
+    return this->builtPrecision == PRECISION_FLOAT ? this->particlesFloat.size() : this->particles.size();
+}
 
-        if (currentPoint->isFixed() == true) {
-            // skip if point cannot move
-            continue;
-        }
+glm::dvec3 Cube::getPosition(int i) const {
+    return this->builtPrecision == PRECISION_FLOAT ? glm::dvec3(this->particlesFloat.getPosition(i)) : this->particles.getPosition(i);
+}
+
+glm::dvec3 Cube::getVelocity(int i) const {
+    return this->builtPrecision == PRECISION_FLOAT ? glm::dvec3(this->particlesFloat.getVelocity(i)) : this->particles.getVelocity(i);
+}
+
+glm::dvec3 Cube::getInitialPosition(int i) const {
+    return this->builtPrecision == PRECISION_FLOAT ? glm::dvec3(this->particlesFloat.getInitialPosition(i)) : this->particles.getInitialPosition(i);
+}
+
+glm::vec3 Cube::getRenderPosition(int i) const {
+    const glm::vec3 current = this->builtPrecision == PRECISION_FLOAT ? this->particlesFloat.getPosition(i) : glm::vec3(this->particles.getPosition(i));
+    if (this->renderBlend >= 1.0f || this->previousPositions.empty()) {
+        return current;
+    }
+    return glm::mix(this->previousPositions[i], current, this->renderBlend);
+}
 
-        currentPoint->setExternalForce(force); 
+void Cube::storePreviousState() {
+    this->previousPositions.resize(this->pointCount());
+    for (int i = 0; i < this->pointCount(); i++) {
+        this->previousPositions[i] = this->builtPrecision == PRECISION_FLOAT ? this->particlesFloat.getPosition(i) : glm::vec3(this->particles.getPosition(i));
+    }
+}
+
+bool Cube::isSurfacePoint(int i) const {
+    return this->builtPrecision == PRECISION_FLOAT ? this->particlesFloat.isSurfacePoint(i) : this->particles.isSurfacePoint(i);
+}
+
+void Cube::setPosition(int i, glm::dvec3 position) {
+    if (this->builtPrecision == PRECISION_FLOAT) {
+        this->particlesFloat.setPosition(i, glm::vec3(position));
+    }
+    else {
+        this->particles.setPosition(i, position);
+    }
+}
+
+void Cube::setVelocity(int i, glm::dvec3 velocity) {
+    if (this->builtPrecision == PRECISION_FLOAT) {
+        this->particlesFloat.setVelocity(i, glm::vec3(velocity));
+    }
+    else {
+        this->particles.setVelocity(i, velocity);
+    }
+}
+
+void Cube::setExternalForce(glm::dvec3 force) {
+    // only applied to points that can move
+    if (force != this->externalForce) {
+        // accelerations kept by velocity Verlet were found with the old force
+        this->accelerationCurrent = false;
     }
+    this->externalForce = force;
 }
 
-void Cube::addTriangle(glm::dvec3* posA, glm::dvec3* posB, glm::dvec3* posC) {
+void Cube::addTriangle(const glm::vec3& posA, const glm::vec3& posB, const glm::vec3& posC) {
 
     // normal
-    glm::dvec3 normal = glm::cross(*posB - *posA, *posC - *posA); // point 2 - point 1  x  point 3 - point 1
+    glm::vec3 normal = glm::cross(posB - posA, posC - posA); // point 2 - point 1  x  point 3 - point 1
     normal = glm::normalize(normal);
 
     // point 1
     // position
-    this->data.push_back(posA->x);
-    this->data.push_back(posA->y);
-    this->data.push_back(posA->z);
+    this->data.push_back(posA.x);
+    this->data.push_back(posA.y);
+    this->data.push_back(posA.z);
     // uv texture coord
     this->texData.push_back(0); // u
     this->texData.push_back(0); // v
@@ -211,9 +358,9 @@ void Cube::addTriangle(glm::dvec3* posA, glm::dvec3* posB, glm::dvec3* posC) {
     
     // point 2
     // position
-    this->data.push_back(posB->x);
-    this->data.push_back(posB->y);
-    this->data.push_back(posB->z);
+    this->data.push_back(posB.x);
+    this->data.push_back(posB.y);
+    this->data.push_back(posB.z);
     // uv texture coord
     this->texData.push_back(0); // u
     this->texData.push_back(0); // v
@@ -224,9 +371,9 @@ void Cube::addTriangle(glm::dvec3* posA, glm::dvec3* posB, glm::dvec3* posC) {
 
     // point 3
     // position
-    this->data.push_back(posC->x);
-    this->data.push_back(posC->y);
-    this->data.push_back(posC->z);
+    this->data.push_back(posC.x);
+    this->data.push_back(posC.y);
+    this->data.push_back(posC.z);
     // uv texture coord
     this->texData.push_back(0); // u
     this->texData.push_back(0); // v
@@ -245,23 +392,22 @@ void Cube::render(GLuint modelParameter, bool showDiscrete, bool showSpring, boo
     if (debugMode) {
         // only draw points, including showing discrete points 
 
-        for (int i = 0; i < this->discretePoints.size(); i++) {
-            MassPoint* massPoint = discretePoints[i];
-            const glm::dvec3* pos = massPoint->getPosition();
+        for (int i = 0; i < this->pointCount(); i++) {
+            const glm::vec3 pos = this->getRenderPosition(i);
 
             if (showDiscrete) {
                 // show mass points inside the surface
-                data.push_back(pos->x);
-                data.push_back(pos->y);
-                data.push_back(pos->z);
+                data.push_back(pos.x);
+                data.push_back(pos.y);
+                data.push_back(pos.z);
             }
             else {
                 // only show surface
-                if (massPoint->isSurfacePoint()) {
+                if (this->isSurfacePoint(i)) {
 
-                    data.push_back(pos->x);
-                    data.push_back(pos->y);
-                    data.push_back(pos->z);
+                    data.push_back(pos.x);
+                    data.push_back(pos.y);
+                    data.push_back(pos.z);
                 }
             }
         }
@@ -278,43 +424,40 @@ void Cube::render(GLuint modelParameter, bool showDiscrete, bool showSpring, boo
 
         if (showSpring) {
             // show springs
-            for (int i = 0; i < this->discretePoints.size(); i++) {
-                MassPoint* massPoint = discretePoints[i];
-                const glm::dvec3* pos = massPoint->getPosition();
-                const int cc = massPoint->getConnectionCount();
+            for (int i = 0; i < this->pointCount(); i++) {
+                const glm::vec3 pos = this->getRenderPosition(i);
+                const Connectivity::Range connected = this->connections.neighbors(i);
 
                 if (showDiscrete) {
-                    for (int c = 0; c < cc; c++) {
-                        MassPoint* connection = massPoint->getConnection(c);
+                    for (const uint32_t connection : connected) {
 
-                        this->data.push_back(pos->x);
-                        this->data.push_back(pos->y);
-                        this->data.push_back(pos->z);
+                        this->data.push_back(pos.x);
+                        this->data.push_back(pos.y);
+                        this->data.push_back(pos.z);
 
-                        const glm::dvec3* cpos = connection->getPosition();
+                        const glm::vec3 cpos = this->getRenderPosition(connection);
 
-                        this->data.push_back(cpos->x);
-                        this->data.push_back(cpos->y);
-                        this->data.push_back(cpos->z);
+                        this->data.push_back(cpos.x);
+                        this->data.push_back(cpos.y);
+                        this->data.push_back(cpos.z);
                     }
                 }
                 else {
                     // only show surface connection with surface
-                    if (massPoint->isSurfacePoint()) {
-                        for (int c = 0; c < cc; c++) {
-                            MassPoint* connection = massPoint->getConnection(c);
+                    if (this->isSurfacePoint(i)) {
+                        for (const uint32_t connection : connected) {
 
-                            if (connection->isSurfacePoint()) {
+                            if (this->isSurfacePoint(connection)) {
 
-                                this->data.push_back(pos->x);
-                                this->data.push_back(pos->y);
-                                this->data.push_back(pos->z);
+                                this->data.push_back(pos.x);
+                                this->data.push_back(pos.y);
+                                this->data.push_back(pos.z);
 
-                                const glm::dvec3* cpos = connection->getPosition();
+                                const glm::vec3 cpos = this->getRenderPosition(connection);
 
-                                this->data.push_back(cpos->x);
-                                this->data.push_back(cpos->y);
-                                this->data.push_back(cpos->z);
+                                this->data.push_back(cpos.x);
+                                this->data.push_back(cpos.y);
+                                this->data.push_back(cpos.z);
                             }
                         }
                     }
@@ -332,15 +475,9 @@ void Cube::render(GLuint modelParameter, bool showDiscrete, bool showSpring, boo
         // draw only surface (triangle faces)
 
         for (int i = 0; i < frontFaces.size(); i++) {
-            std::vector <MassPoint*>* face = frontFaces[i];
+            std::vector <int>* face = frontFaces[i];
             const int maxSize = face->size();
             for (int f = 0; f < maxSize; f++) {
-                MassPoint* massPointA;
-                MassPoint* massPointB;
-                MassPoint* massPointC;
-                glm::dvec3* posA;
-                glm::dvec3* posB;
-                glm::dvec3* posC;
 
                 // draw 2 triangles per square face
                 // counter clockwise winding order
@@ -352,59 +489,37 @@ void Cube::render(GLuint modelParameter, bool showDiscrete, bool showSpring, boo
                     if ((f + resolution) < maxSize) {
                         // triangle 1
                         // point 1 
-                        massPointA = (*face)[f];
-                        posA = massPointA->getPosition();
-                        massPointB = (*face)[f + 1];
-                        posB = massPointB->getPosition();
-                        massPointC = (*face)[f + resolution];
-                        posC = massPointC->getPosition();
-                        addTriangle(posA, posB, posC);
+                        addTriangle(this->getRenderPosition((*face)[f]),
+                            this->getRenderPosition((*face)[f + 1]),
+                            this->getRenderPosition((*face)[f + resolution]));
 
                         // triangle 2
-                        massPointA = (*face)[f + 1];
-                        posA = massPointA->getPosition();
-                        massPointB = (*face)[f + 1 + resolution];
-                        posB = massPointB->getPosition();
-                        massPointC = (*face)[f + resolution];
-                        posC = massPointC->getPosition();
-                        addTriangle(posA, posB, posC);
+                        addTriangle(this->getRenderPosition((*face)[f + 1]),
+                            this->getRenderPosition((*face)[f + 1 + resolution]),
+                            this->getRenderPosition((*face)[f + resolution]));
                     }
                 }
             }
         }
 
         for (int i = 0; i < backFaces.size(); i++) {
-            std::vector <MassPoint*>* face = backFaces[i];
+            std::vector <int>* face = backFaces[i];
             const int maxSize = face->size();
             for (int f = 0; f < maxSize; f++) {
-                MassPoint* massPointA;
-                MassPoint* massPointB;
-                MassPoint* massPointC;
-                glm::dvec3* posA;
-                glm::dvec3* posB;
-                glm::dvec3* posC;
                 // counter clockwise
 
                 if (((f + 1) % this->resolution) != 0) {
 
                     if ((f + resolution) < maxSize) {
                         // triangle 1
-                        massPointA = (*face)[f + resolution];
-                        posA = massPointA->getPosition();
-                        massPointB = (*face)[f + 1];
-                        posB = massPointB->getPosition();
-                        massPointC = (*face)[f];
-                        posC = massPointC->getPosition();
-                        addTriangle(posA, posB, posC);
+                        addTriangle(this->getRenderPosition((*face)[f + resolution]),
+                            this->getRenderPosition((*face)[f + 1]),
+                            this->getRenderPosition((*face)[f]));
 
                         // triangle 2
-                        massPointA = (*face)[f + resolution];
-                        posA = massPointA->getPosition();
-                        massPointB = (*face)[f + 1 + resolution];
-                        posB = massPointB->getPosition();
-                        massPointC = (*face)[f + 1];
-                        posC = massPointC->getPosition();
-                        addTriangle(posA, posB, posC);
+                        addTriangle(this->getRenderPosition((*face)[f + resolution]),
+                            this->getRenderPosition((*face)[f + 1 + resolution]),
+                            this->getRenderPosition((*face)[f + 1]));
                     }
                 }
 
@@ -479,7 +594,34 @@ void Cube::initArrays() {
 }
 
 void Cube::setSpringMode(bool structural, bool shear, bool bend) {
-    this->discretePoints.clear();
+    // drop the old topology, O(1), the next build reuses the same block
+    this->topology.reset();
+    this->particles.clear();
+    this->particlesFloat.clear();
+    this->springs.clear();
+    this->connections.clear();
+    this->latticeToParticle = nullptr;
+    this->rk4.clear();
+    this->rk4Float.clear();
+    this->implicitEuler.clear();
+    this->implicitEulerFloat.clear();
+    this->adaptive.clear();
+    this->adaptiveFloat.clear();
+    this->xpbd.clear();
+    this->xpbdFloat.clear();
+    this->positionVerlet.clear();
+    this->positionVerletFloat.clear();
+    this->multirate.clear();
+    this->multirateFloat.clear();
+    this->selfCollider.clear();
+    this->selfColliderFloat.clear();
+    this->sweptCollider.clear();
+    this->sweptColliderFloat.clear();
+    this->accelerationCurrent = false;
+    this->velocityCurrent = true;
+    // world contacts belong to the old points, the world finds them again on its next step
+    this->bodyContacts = 0;
+    this->previousPositions.clear();
     for (const auto& f : frontFaces) {
         f->clear();
     }
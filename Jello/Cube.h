@@ -11,8 +11,30 @@
 
 #include <vector>
 
-#include "MassPoint.h"
+#include "Arena.h"
+#include "ParticleStore.h"
+#include "SpringTable.h"
+#include "Connectivity.h"
+#include "LatticeStencil.h"
+#include "SpringKernels.h"
+#include "RK4Integrator.h"
+#include "ImplicitEulerIntegrator.h"
+#include "AdaptiveIntegrator.h"
+#include "XPBDIntegrator.h"
+#include "PositionVerletIntegrator.h"
+#include "MultirateIntegrator.h"
+#include "ProjectiveDynamicsIntegrator.h"
+#include "StabilityEstimator.h"
+#include "SelfCollider.h"
+#include "SweptCollider.h"
 
+enum particleOrderEnum {
+    ORDER_LATTICE, ORDER_MORTON
+}; // lattice = 0, morton = 1
+
+enum precisionEnum {
+    PRECISION_DOUBLE, PRECISION_FLOAT
+}; // double = 0, float = 1
 
 class Cube {
     // jello cube
@@ -21,6 +43,10 @@ class Cube {
 
         Cube(); // default constructor
         Cube(int resolution, glm::vec3 position, GLint shader, GLint debug);
+        ~Cube();
+        // owns its vertex array and buffers
+        Cube(const Cube&) = delete;
+        Cube& operator=(const Cube&) = delete;
         
         // setup
         void setSpringMode(bool structural, bool shear, bool bend);
@@ -29,11 +55,64 @@ class Cube {
         // render
         void render(GLuint modelParameter, bool showDiscrete, bool showSpring, bool debugMode);
         int pointSize = 5;
+        // rendered position = previous + (current - previous) * renderBlend, set by the simulation clock
+        float renderBlend = 1.0f;
+        // keeps the current positions as the previous state, called before the last step of a frame
+        void storePreviousState();
         
         // physics 
         float stiffness = 1500.0f; // store as positive and negate in function so it makes more sense in ImGui
         float damping = 0.5f; // store as positive and negate in function so it makes more sense in ImGui
         float mass = 1.0f;
+        // stiffness multiplier per spring type (indexed by springTypeEnum)
+        float springTypeStiffness[SPRING_TYPE_COUNT] = { 1.0f, 1.0f, 1.0f };
+        // gather spring forces per point from the lattice stencil instead of the spring table
+        bool latticeGather = false;
+        // order of the points in the particle store (particleOrderEnum), applied on the next reset
+        // morton (z-order curve) keeps lattice neighbors close in memory along all three axes
+        int particleOrder = ORDER_LATTICE;
+        // scalar of the simulation (precisionEnum), applied on the next reset
+        // float halves the bandwidth and doubles the vector width, double is more stable at large stiffness
+        int precision = PRECISION_DOUBLE;
+        // highest vector instruction set for the spring table pass (simdLevelEnum), clamped to what the cpu supports
+        int simdLevel = SIMD_AVX512;
+        // conjugate gradient of the implicit integrator: iteration cap, relative residual to stop at,
+        // and what the last step reached
+        int solverIterations = 100;
+        float solverTolerance = 1e-4f;
+        SolverStats solverStats{};
+        // adaptive integrator: bounds of the step size (s), error tolerance per step, and the steps it took
+        float adaptiveMinStep = 1e-5f;
+        float adaptiveMaxStep = 0.01f;
+        float adaptiveTolerance = 1e-3f;
+        StepHistory stepHistory{};
+        // XPBD solver: substeps per step and constraint passes per substep
+        int xpbdSubsteps = 4;
+        int xpbdIterations = 10;
+        // projective dynamics: local / global iterations per step, and the factor it solves with
+        int pdIterations = 10;
+        ProjectiveDynamicsStats pdStats{};
+        // explicit integrators split a step into substeps below the estimated stability limit,
+        // the limit is scaled by the safety factor and the substeps are capped
+        bool autoSubstep = true;
+        float stabilitySafety = 0.9f;
+        int maxStableSubsteps = 64;
+        StabilityLimit stabilityLimit{};
+        // multirate integrator: fine steps per step of the fast points, stiffness multiplier above which
+        // a spring type counts as stiff, and what the last step split off
+        int multirateSubsteps = 8;
+        float multirateStiffThreshold = 1.5f;
+        MultirateStats multirateStats{};
+        // collision of the surface points with the surface triangles of the cube itself,
+        // the thickness is a fraction of the lattice spacing
+        bool selfCollision = false;
+        float selfCollisionThickness = 0.25f;
+        SelfCollisionStats selfCollisionStats{};
+        // continuous collision: points are swept from their start to their end of every step against the walls
+        // and the obstacles, so a fast point cannot pass through them within one step, and bounces off at the impact
+        bool sweptCollision = false;
+        float sweptRestitution = 0.5f;
+        SweptCollisionStats sweptCollisionStats{};
 
         // adjustable values
         int resolution = 1;
@@ -42,22 +121,98 @@ class Cube {
         bool shearSpring;
         bool bendSpring;
         bool fixedFloor = true;
+        // corner of the lattice in the frame of the cube (m), the cubes of a world share one frame and start apart by it
+        glm::vec3 latticeOrigin = glm::vec3(0.0f);
 
-        // mass points will be stored in discretePoints list but also per faces 
-        // faces only store surface points 
-        std::vector <MassPoint*> discretePoints{};
+        // particles, connections and springs of the current resolution, reset releases all of them at once
+        Arena topology{};
+        // mass points are stored in the particle store (structure of arrays) of the precision the cube was built with,
+        // the other one stays empty
+        // faces only store indices of surface points 
+        ParticleStore <double> particles{};
+        ParticleStore <float> particlesFloat{};
+        // connected point indices per point (depends on the spring types enabled)
+        Connectivity connections{};
+        // particle index of every lattice point (j * res + k) * res + i, nullptr when they are the same
+        int* latticeToParticle = nullptr;
+        // every spring once, with cached rest length and type
+        SpringTable springs{};
+        // neighbor offsets of the regular lattice, used by the gather force pass
+        LatticeStencil stencil{};
+        // stage buffers of the RK4 integrator, sized with the topology
+        RK4Integrator <double> rk4{};
+        RK4Integrator <float> rk4Float{};
+        // the accelerations in the particle store belong to the current state (left by a velocity Verlet step),
+        // the next velocity Verlet step reuses them instead of evaluating the forces again, anything that changes
+        // the forces between steps (external force, plate, contacts of the world, parameters) clears it
+        bool accelerationCurrent = false;
+        // the velocities in the particle store belong to the current state, false while the position Verlet
+        // integrator carries the state as current and previous positions (Physics syncVelocity derives them)
+        bool velocityCurrent = true;
+        // spring Jacobians and solver vectors of the implicit Euler integrator
+        ImplicitEulerIntegrator <double> implicitEuler{};
+        ImplicitEulerIntegrator <float> implicitEulerFloat{};
+        // stage buffers and step size of the adaptive Runge-Kutta integrator
+        AdaptiveIntegrator <double> adaptive{};
+        AdaptiveIntegrator <float> adaptiveFloat{};
+        // previous positions and spring multipliers of the XPBD solver
+        XPBDIntegrator <double> xpbd{};
+        XPBDIntegrator <float> xpbdFloat{};
+        // previous positions of the position Verlet integrator
+        PositionVerletIntegrator <double> positionVerlet{};
+        PositionVerletIntegrator <float> positionVerletFloat{};
+        // stiff springs per point and fast points of the multirate integrator
+        MultirateIntegrator <double> multirate{};
+        MultirateIntegrator <float> multirateFloat{};
+        // cached Cholesky factor of the projective dynamics system, kept across resets while the key matches
+        ProjectiveDynamicsIntegrator <double> projectiveDynamics{};
+        ProjectiveDynamicsIntegrator <float> projectiveDynamicsFloat{};
+        // surface triangles and spatial hash of the self collision
+        SelfCollider <double> selfCollider{};
+        SelfCollider <float> selfColliderFloat{};
+        // start positions of the swept collision
+        SweptCollider <double> sweptCollider{};
+        SweptCollider <float> sweptColliderFloat{};
+        // frequency bound of the spring stencil, cached per spring types
+        StabilityEstimator stabilityEstimator{};
         // faces to render triangles
-        std::vector <MassPoint*> topFace{};
-        std::vector <MassPoint*> bottomFace{};
-        std::vector <MassPoint*> rightFace{};
-        std::vector <MassPoint*> leftFace{};
-        std::vector <MassPoint*> frontFace{};
-        std::vector <MassPoint*> backFace{};
-        std::vector <std::vector <MassPoint*>*> frontFaces{ &frontFace, &leftFace, &bottomFace }; 
-        std::vector <std::vector <MassPoint*>*> backFaces{ &rightFace, &backFace, &topFace }; // different winding order
+        std::vector <int> topFace{};
+        std::vector <int> bottomFace{};
+        std::vector <int> rightFace{};
+        std::vector <int> leftFace{};
+        std::vector <int> frontFace{};
+        std::vector <int> backFace{};
+        std::vector <std::vector <int>*> frontFaces{ &frontFace, &leftFace, &bottomFace }; 
+        std::vector <std::vector <int>*> backFaces{ &rightFace, &backFace, &topFace }; // different winding order
+
+        // acceleration of every point from contacts with other cubes of a world, found by the world at the start
+        // of its step and held over the step; bodyContacts counts its points and triangle corners touching
+        // (0 outside a world)
+        std::vector <glm::dvec3> bodyContact{};
+        int bodyContacts = 0;
+
+        // external force applied to every point that is not fixed
+        glm::dvec3 externalForce = glm::dvec3(0.0);
 
         void resetAcceleration();
         void setExternalForce(glm::dvec3 force);
+        int pointIndex(int i, int j, int k) const;
+
+        // precision the particles were built with, the store of that precision holds the points
+        int getPrecision() const { return this->builtPrecision; }
+        template <typename Real>
+        ParticleStore <Real>& getParticles();
+        template <typename Real>
+        SelfCollider <Real>& getSelfCollider();
+
+        // per point access that does not depend on the precision
+        int pointCount() const;
+        glm::dvec3 getPosition(int i) const;
+        glm::dvec3 getVelocity(int i) const;
+        glm::dvec3 getInitialPosition(int i) const;
+        bool isSurfacePoint(int i) const;
+        void setPosition(int i, glm::dvec3 position);
+        void setVelocity(int i, glm::dvec3 velocity);
 
     private:
         // render
@@ -68,11 +223,16 @@ class Cube {
         std::vector <GLfloat> data{}; // stores vertex positions {x1, y1, z1, x2, y2, z2}
         std::vector <GLfloat> texData{}; // stores UV per vertex {u1, v1, u2, v2}
         std::vector <GLfloat> normalData{}; // stores normal vector xyz per vertex {x1, y1, z1, x2, y2, z2}
+        std::vector <glm::vec3> previousPositions{}; // positions before the last step, empty until the first store
+
+        int builtPrecision = PRECISION_DOUBLE;
 
         void initArrays();
         void fillDiscretePoints(bool structural, bool shear, bool bend);
-        void addConnection(MassPoint**** massPointMap, MassPoint* point, int i, int j, int k);
-        void addTriangle(glm::dvec3* pointA, glm::dvec3* pointB, glm::dvec3* pointC);
+        void addConnection(int point, int i, int j, int k, springTypeEnum type);
+        void addTriangle(const glm::vec3& pointA, const glm::vec3& pointB, const glm::vec3& pointC);
+        // position as uploaded to the GPU, float points need no conversion, blended with the previous state
+        glm::vec3 getRenderPosition(int i) const;
 
         glm::vec3 position = glm::vec3(0.0f);
         // unit cube (m)
@@ -91,4 +251,13 @@ class Cube {
 };
 
 
+template <>
+inline ParticleStore <double>& Cube::getParticles <double>() { return this->particles; }
+template <>
+inline ParticleStore <float>& Cube::getParticles <float>() { return this->particlesFloat; }
+template <>
+inline SelfCollider <double>& Cube::getSelfCollider <double>() { return this->selfCollider; }
+template <>
+inline SelfCollider <float>& Cube::getSelfCollider <float>() { return this->selfColliderFloat; }
+
 #endif
\ No newline at end of file
@@ -0,0 +1,252 @@
+#include "Ensemble.h"
+#include "Physics.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * builds the ensemble from a cube, every instance starts with the cube's state and parameters
+ * @param Cube* cube - cube with the topology, has to keep it while the ensemble is used
+ * @param int instances - number of independent cubes
+ */
+template <typename Real>
+Ensemble<Real>::Ensemble(Cube* cube, int instances) : springs(cube->springs) {
+    this->instances = std::max(1, instances);
+    this->points = cube->pointCount();
+    for (int t = 0; t < SPRING_TYPE_COUNT; t++) {
+        this->typeStiffness[t] = Real(cube->springTypeStiffness[t]);
+    }
+
+    const size_t state = size_t(this->points) * size_t(this->instances);
+    this->buffers.reserve(9 * Arena::bytesFor<Real>(state) + 5 * Arena::bytesFor<Real>(this->instances)
+        + 7 * Arena::bytesFor<Real>(this->points));
+    Real** stateBuffers[9] = { &this->px, &this->py, &this->pz, &this->vx, &this->vy, &this->vz, &this->ax, &this->ay, &this->az };
+    for (Real** buffer : stateBuffers) {
+        *buffer = this->buffers.allocate<Real>(state);
+    }
+    Real** instanceBuffers[5] = { &this->stiffness, &this->damping, &this->inverseMass, &this->timeStep, &this->currentStep };
+    for (Real** buffer : instanceBuffers) {
+        *buffer = this->buffers.allocate<Real>(this->instances);
+    }
+    Real** pointBuffers[7] = { &this->freePoint, &this->startX, &this->startY, &this->startZ, &this->startVX, &this->startVY, &this->startVZ };
+    for (Real** buffer : pointBuffers) {
+        *buffer = this->buffers.allocate<Real>(this->points);
+    }
+
+    for (int i = 0; i < this->points; i++) {
+        const bool fixed = cube->getPrecision() == PRECISION_FLOAT ? cube->particlesFloat.isFixed(i) : cube->particles.isFixed(i);
+        const glm::dvec3 position = cube->getPosition(i);
+        const glm::dvec3 velocity = cube->getVelocity(i);
+        this->freePoint[i] = fixed ? Real(0) : Real(1);
+        this->startX[i] = Real(position.x); this->startY[i] = Real(position.y); this->startZ[i] = Real(position.z);
+        this->startVX[i] = Real(velocity.x); this->startVY[i] = Real(velocity.y); this->startVZ[i] = Real(velocity.z);
+    }
+
+    for (int n = 0; n < this->instances; n++) {
+        this->setParameters(n, cube->stiffness, cube->damping, cube->mass, 0.001);
+    }
+    this->externalForce = cube->externalForce;
+    this->reset();
+}
+
+/**
+ * parameters of one instance
+ * @param int instance - instance index
+ * @param double stiffness, double damping, double mass - same meaning as on the cube
+ * @param double timeStep - dt of the instance
+ */
+template <typename Real>
+void Ensemble<Real>::setParameters(int instance, double stiffness, double damping, double mass, double timeStep) {
+    this->stiffness[instance] = Real(stiffness);
+    this->damping[instance] = Real(damping);
+    this->inverseMass[instance] = Real(1.0 / mass);
+    this->timeStep[instance] = Real(timeStep);
+}
+
+// every instance back to the state of the cube the ensemble was built from
+template <typename Real>
+void Ensemble<Real>::reset() {
+    const int N = this->instances;
+
+    #pragma omp parallel for
+    for (int i = 0; i < this->points; i++) {
+        for (int n = 0; n < N; n++) {
+            const size_t j = size_t(i) * N + n;
+            this->px[j] = this->startX[i]; this->py[j] = this->startY[i]; this->pz[j] = this->startZ[i];
+            this->vx[j] = this->startVX[i]; this->vy[j] = this->startVY[i]; this->vz[j] = this->startVZ[i];
+        }
+    }
+}
+
+/**
+ * spring and damping accelerations of one spring for every instance, one vector loop over the instances
+ * (the square root only vectorizes where it does not set errno: msvc, or -fno-math-errno on gcc and clang)
+ * @param int s - spring index
+ */
+template <typename Real>
+void Ensemble<Real>::accumulateSpring(int s) {
+    const int N = this->instances;
+    const size_t a = size_t(this->springs.pointA[s]) * N;
+    const size_t b = size_t(this->springs.pointB[s]) * N;
+    const Real rest = this->springs.getRestLength<Real>()[s];
+    const Real kt = this->typeStiffness[this->springs.type[s]];
+
+    const Real* px = this->px; const Real* py = this->py; const Real* pz = this->pz;
+    const Real* vx = this->vx; const Real* vy = this->vy; const Real* vz = this->vz;
+    Real* ax = this->ax; Real* ay = this->ay; Real* az = this->az;
+    const Real* stiffness = this->stiffness;
+    const Real* damping = this->damping;
+    const Real* inverseMass = this->inverseMass;
+
+    #pragma omp simd
+    for (int n = 0; n < N; n++) {
+        const Real lx = px[a + n] - px[b + n];
+        const Real ly = py[a + n] - py[b + n];
+        const Real lz = pz[a + n] - pz[b + n];
+        const Real length2 = lx * lx + ly * ly + lz * lz;
+        const Real invLength = Real(1) / std::sqrt(length2);
+        const Real length = length2 * invLength;
+        const Real dvDotL = (vx[a + n] - vx[b + n]) * lx + (vy[a + n] - vy[b + n]) * ly + (vz[a + n] - vz[b + n]) * lz;
+
+        // spring and damping share the direction L / |L|
+        const Real scale = (-stiffness[n] * kt * (length - rest) - damping[n] * dvDotL * invLength) * invLength * inverseMass[n];
+        ax[a + n] += scale * lx; ay[a + n] += scale * ly; az[a + n] += scale * lz;
+        ax[b + n] -= scale * lx; ay[b + n] -= scale * ly; az[b + n] -= scale * lz;
+    }
+}
+
+/**
+ * spring and damping accelerations of every instance, starting from the external acceleration,
+ * springs of a color never share a point so they run in parallel
+ */
+template <typename Real>
+void Ensemble<Real>::computeSprings() {
+    const int N = this->instances;
+    const Real fx = Real(this->externalForce.x), fy = Real(this->externalForce.y), fz = Real(this->externalForce.z);
+
+    #pragma omp parallel for
+    for (int i = 0; i < this->points; i++) {
+        Real* ax = this->ax + size_t(i) * N;
+        Real* ay = this->ay + size_t(i) * N;
+        Real* az = this->az + size_t(i) * N;
+        const Real* inverseMass = this->inverseMass;
+        #pragma omp simd
+        for (int n = 0; n < N; n++) {
+            ax[n] = fx * inverseMass[n];
+            ay[n] = fy * inverseMass[n];
+            az[n] = fz * inverseMass[n];
+        }
+    }
+
+    this->springs.forEachColored([&](int s) {
+        this->accumulateSpring(s);
+    });
+}
+
+/**
+ * wall contacts and the symplectic Euler update of every point, fixed points are masked instead of skipped
+ * the contact is a rest length 0 spring towards the closest point of the box with 50 times the damping,
+ * like the cube's collision response
+ */
+template <typename Real>
+void Ensemble<Real>::integrate() {
+    const int N = this->instances;
+    const Real minX = Real(boundingBox->minX), maxX = Real(boundingBox->maxX);
+    const Real minY = Real(boundingBox->minY), maxY = Real(boundingBox->maxY);
+    const Real minZ = Real(boundingBox->minZ), maxZ = Real(boundingBox->maxZ);
+
+    Real* px = this->px; Real* py = this->py; Real* pz = this->pz;
+    Real* vx = this->vx; Real* vy = this->vy; Real* vz = this->vz;
+    const Real* ax = this->ax; const Real* ay = this->ay; const Real* az = this->az;
+    const Real* stiffness = this->stiffness;
+    const Real* damping = this->damping;
+    const Real* inverseMass = this->inverseMass;
+    const Real* currentStep = this->currentStep;
+
+    #pragma omp parallel for
+    for (int i = 0; i < this->points; i++) {
+        const size_t j = size_t(i) * N;
+        const Real free = this->freePoint[i];
+
+        #pragma omp simd
+        for (int n = 0; n < N; n++) {
+            Real x = px[j + n], y = py[j + n], z = pz[j + n];
+            Real u = vx[j + n], v = vy[j + n], w = vz[j + n];
+
+            // penetration, 0 inside the box (selects instead of std::min / std::max, which take the address)
+            const Real dx = x < minX ? x - minX : (x > maxX ? x - maxX : Real(0));
+            const Real dy = y < minY ? y - minY : (y > maxY ? y - maxY : Real(0));
+            const Real dz = z < minZ ? z - minZ : (z > maxZ ? z - maxZ : Real(0));
+            const Real depth2 = dx * dx + dy * dy + dz * dz;
+            const Real inverseDepth2 = depth2 > Real(0) ? Real(1) / depth2 : Real(0);
+            const Real contact = (-stiffness[n] - Real(50) * damping[n] * (u * dx + v * dy + w * dz) * inverseDepth2) * inverseMass[n];
+
+            const Real dt = currentStep[n] * free;
+            u += (ax[j + n] + contact * dx) * dt;
+            v += (ay[j + n] + contact * dy) * dt;
+            w += (az[j + n] + contact * dz) * dt;
+            x += u * dt;
+            y += v * dt;
+            z += w * dt;
+
+            px[j + n] = x; py[j + n] = y; pz[j + n] = z;
+            vx[j + n] = u; vy[j + n] = v; vz[j + n] = w;
+        }
+    }
+}
+
+// one step of every instance with its own time step
+template <typename Real>
+void Ensemble<Real>::step() {
+    std::copy(this->timeStep, this->timeStep + this->instances, this->currentStep);
+    this->computeSprings();
+    this->integrate();
+}
+
+/**
+ * advances every instance by the same simulated time in steps of its own time step,
+ * instances with larger steps are done earlier and sit out the remaining passes with a step of 0
+ * @param double time - simulated time (s)
+ */
+template <typename Real>
+void Ensemble<Real>::advance(double time) {
+    int passes = 0;
+    for (int n = 0; n < this->instances; n++) {
+        passes = std::max(passes, int(time / double(this->timeStep[n]) + 0.5));
+    }
+
+    for (int pass = 0; pass < passes; pass++) {
+        for (int n = 0; n < this->instances; n++) {
+            const int steps = int(time / double(this->timeStep[n]) + 0.5);
+            this->currentStep[n] = pass < steps ? this->timeStep[n] : Real(0);
+        }
+        this->computeSprings();
+        this->integrate();
+    }
+}
+
+template <typename Real>
+glm::dvec3 Ensemble<Real>::getPosition(int instance, int point) const {
+    const size_t j = size_t(point) * this->instances + instance;
+    return glm::dvec3(this->px[j], this->py[j], this->pz[j]);
+}
+
+template <typename Real>
+glm::dvec3 Ensemble<Real>::getVelocity(int instance, int point) const {
+    const size_t j = size_t(point) * this->instances + instance;
+    return glm::dvec3(this->vx[j], this->vy[j], this->vz[j]);
+}
+
+template <typename Real>
+double Ensemble<Real>::maxSpeed(int instance) const {
+    double speed = 0.0;
+    for (int i = 0; i < this->points; i++) {
+        const double s = glm::length(this->getVelocity(instance, i));
+        // nan is kept, a comparison with it is always false
+        speed = (s > speed || std::isnan(s)) ? s : speed;
+    }
+    return speed;
+}
+
+template class Ensemble <float>;
+template class Ensemble <double>;
@@ -0,0 +1,71 @@
+#ifndef __ENSEMBLE_H__
+#define __ENSEMBLE_H__
+
+#include <glm/glm.hpp>
+
+#include "Arena.h"
+#include "SpringTable.h"
+
+class Cube;
+
+// many independent jello cubes integrated together, for parameter sweeps in one process
+// every instance shares the springs, rest lengths and fixed points of one cube (the spring table is not copied,
+// the cube has to keep its topology while the ensemble is used) but has its own stiffness, damping, mass and
+// time step, and starts from the state the cube had when the ensemble was built
+// the state is interleaved with the instance index fastest (x[point * instances + instance]), so every loop
+// over a spring or a point runs over all instances with contiguous vector loads
+// a step is one symplectic Euler step of every instance: springs (colored, in parallel), the bounding box
+// as a penalty spring towards the closest point of the box, and the external force
+// Real is the precision of the state and the parameters
+template <typename Real>
+class Ensemble {
+
+    public:
+        Ensemble(Cube* cube, int instances);
+        Ensemble(const Ensemble&) = delete;
+        Ensemble& operator=(const Ensemble&) = delete;
+
+        // external force applied to every point that is not fixed, same for every instance
+        glm::dvec3 externalForce = glm::dvec3(0.0);
+
+        void setParameters(int instance, double stiffness, double damping, double mass, double timeStep);
+        void step();
+        void advance(double time);
+        void reset();
+
+        int size() const { return this->instances; }
+        int pointCount() const { return this->points; }
+        glm::dvec3 getPosition(int instance, int point) const;
+        glm::dvec3 getVelocity(int instance, int point) const;
+        // fastest point of an instance, infinite or nan once it exploded
+        double maxSpeed(int instance) const;
+
+    private:
+        const SpringTable& springs;
+        int instances = 0;
+        int points = 0;
+        // stiffness multiplier per spring type, copied from the cube
+        Real typeStiffness[SPRING_TYPE_COUNT] = {};
+
+        // block for every buffer below
+        Arena buffers{};
+        // state, x[point * instances + instance]
+        Real *px = nullptr, *py = nullptr, *pz = nullptr;
+        Real *vx = nullptr, *vy = nullptr, *vz = nullptr;
+        Real *ax = nullptr, *ay = nullptr, *az = nullptr;
+        // parameters per instance
+        Real *stiffness = nullptr, *damping = nullptr, *inverseMass = nullptr, *timeStep = nullptr;
+        // step of the current pass per instance, 0 for instances that already reached the end of advance
+        Real* currentStep = nullptr;
+        // 1 for free points and 0 for points fixed to the plate, per point
+        Real* freePoint = nullptr;
+        // state of the cube the ensemble was built from, per point
+        Real *startX = nullptr, *startY = nullptr, *startZ = nullptr;
+        Real *startVX = nullptr, *startVY = nullptr, *startVZ = nullptr;
+
+        void accumulateSpring(int s);
+        void computeSprings();
+        void integrate();
+};
+
+#endif
@@ -0,0 +1,305 @@
+#include "ImplicitEulerIntegrator.h"
+#include "Physics.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * dot product of two vectors stored as three arrays, summed in double for both precisions
+ * @param Real* const a[3] - first vector
+ * @param Real* const b[3] - second vector
+ * @param int count - points
+ * @return double - a . b
+ */
+template <typename Real>
+static double dot(Real* const a[3], Real* const b[3], int count) {
+    double sum = 0.0;
+    #pragma omp parallel for reduction(+:sum)
+    for (int i = 0; i < count; i++) {
+        sum += double(a[0][i]) * double(b[0][i]) + double(a[1][i]) * double(b[1][i]) + double(a[2][i]) * double(b[2][i]);
+    }
+    return sum;
+}
+
+/**
+ * lays out the spring blocks and the solver vectors for the current topology
+ * @param Cube* cube - cube to integrate
+ * @param const ParticleStore <Real>& current - state at the start of the step
+ */
+template <typename Real>
+void ImplicitEulerIntegrator<Real>::prepare(Cube* cube, const ParticleStore <Real>& current) {
+    const int count = current.size();
+    const int springCount = cube->springs.size();
+    if (this->buffers.fits(count, springCount)) {
+        return;
+    }
+
+    // 6 arrays per spring, 5 contact arrays and 6 vectors of 3 arrays per point
+    Arena& arena = this->buffers.resize(count, springCount, 6 * Arena::bytesFor<Real>(springCount) + 23 * Arena::bytesFor<Real>(count));
+
+    Real** springArrays[6] = { &nx, &ny, &nz, &stiffnessAlong, &dampingAlong, &stiffnessAcross };
+    for (Real** array : springArrays) {
+        *array = arena.allocate<Real>(springCount);
+    }
+    Real** contactArrays[5] = { &contactNx, &contactNy, &contactNz, &contactAlong, &contactAcross };
+    for (Real** array : contactArrays) {
+        *array = arena.allocate<Real>(count);
+    }
+    Real** vectors[6] = { x, r, z, d, q, inverseDiagonal };
+    for (Real** vector : vectors) {
+        for (int c = 0; c < 3; c++) {
+            vector[c] = arena.allocate<Real>(count);
+        }
+    }
+}
+
+/**
+ * linearises the forces at the current state: Jacobian blocks per spring and contact,
+ * right hand side (into r) and inverse diagonal of the system matrix divided by the mass
+ * @param Cube* cube - cube to integrate
+ * @param const ParticleStore <Real>& current - state at the start of the step, accelerations already computed
+ * @param Real timeStep - dt
+ */
+template <typename Real>
+void ImplicitEulerIntegrator<Real>::assemble(Cube* cube, const ParticleStore <Real>& current, Real timeStep) {
+    typedef glm::vec<3, Real> vec3;
+    const SpringTable& springs = cube->springs;
+    const Real* restLength = springs.getRestLength<Real>();
+    const Real h = timeStep;
+    const Real invMass = Real(1) / Real(cube->mass);
+
+    // stiffness per spring type
+    Real kh[SPRING_TYPE_COUNT];
+    for (int t = 0; t < SPRING_TYPE_COUNT; t++) {
+        kh[t] = Real(cube->stiffness) * Real(cube->springTypeStiffness[t]);
+    }
+    const Real kd = Real(cube->damping);
+    // same penalty spring as processCollisionResponse
+    const Real contactStiffness = Real(cube->stiffness);
+    const Real contactDamping = Real(cube->damping) * Real(50);
+
+    // b = dt * a, diagonal = 1, contact blocks
+    #pragma omp parallel for shared(boundingBox)
+    for (int i = 0; i < current.size(); i++) {
+        const vec3 v = current.getVelocity(i);
+        vec3 b = current.getAcceleration(i) * h;
+        vec3 diagonal = vec3(1);
+
+        this->contactAlong[i] = Real(0);
+        this->contactAcross[i] = Real(0);
+        this->contactNx[i] = this->contactNy[i] = this->contactNz[i] = Real(0);
+
+        glm::dvec3 closestPoint;
+        const glm::dvec3 position = current.getPosition(i);
+        if (checkCollision(position, boundingBox, closestPoint)) {
+            // rest length 0: df/dx = -k * I, df/dv = -kd * n n^T
+            const glm::dvec3 L = position - closestPoint;
+            const double length = glm::length(L);
+            const vec3 n = length > 0.0 ? vec3(L / length) : vec3(0);
+            const Real along = h * contactDamping * invMass;
+            const Real across = h * h * contactStiffness * invMass;
+
+            this->contactNx[i] = n.x; this->contactNy[i] = n.y; this->contactNz[i] = n.z;
+            this->contactAlong[i] = along;
+            this->contactAcross[i] = across;
+
+            b -= across * v;
+            diagonal += along * n * n + vec3(across);
+        }
+
+        if (current.isFixed(i)) {
+            b = vec3(0);
+        }
+        this->r[0][i] = b.x; this->r[1][i] = b.y; this->r[2][i] = b.z;
+        this->inverseDiagonal[0][i] = diagonal.x; this->inverseDiagonal[1][i] = diagonal.y; this->inverseDiagonal[2][i] = diagonal.z;
+    }
+
+    // spring blocks, scattered into both end points
+    springs.forEachColored([&](int s) {
+        const int a = springs.pointA[s];
+        const int bPoint = springs.pointB[s];
+        const vec3 L = current.getPosition(a) - current.getPosition(bPoint);
+        const Real length = glm::length(L);
+        const vec3 n = length > Real(0) ? L / length : vec3(0);
+
+        // df/dx = -k * ((r / l) * n n^T + (1 - r / l) * I), the transverse part is dropped
+        // while compressed so the matrix stays positive definite
+        const Real stretch = length > Real(0) ? std::max(Real(0), Real(1) - restLength[s] / length) : Real(0);
+        const Real k = kh[springs.type[s]];
+        const Real along = h * h * k * (Real(1) - stretch) * invMass;
+        const Real across = h * h * k * stretch * invMass;
+        const Real damp = h * kd * invMass;
+
+        this->nx[s] = n.x; this->ny[s] = n.y; this->nz[s] = n.z;
+        this->stiffnessAlong[s] = along;
+        this->dampingAlong[s] = damp;
+        this->stiffnessAcross[s] = across;
+
+        // b -= dt^2 / m * df/dx * v (negative Jacobian, so the sign flips)
+        const vec3 dv = current.getVelocity(a) - current.getVelocity(bPoint);
+        const vec3 kv = along * glm::dot(n, dv) * n + across * dv;
+        const vec3 diagonal = (along + damp) * n * n + vec3(across);
+
+        if (!current.isFixed(a)) {
+            this->r[0][a] -= kv.x; this->r[1][a] -= kv.y; this->r[2][a] -= kv.z;
+        }
+        if (!current.isFixed(bPoint)) {
+            this->r[0][bPoint] += kv.x; this->r[1][bPoint] += kv.y; this->r[2][bPoint] += kv.z;
+        }
+        for (int c = 0; c < 3; c++) {
+            this->inverseDiagonal[c][a] += diagonal[c];
+            this->inverseDiagonal[c][bPoint] += diagonal[c];
+        }
+    });
+
+    // fixed points stay out of the solve
+    #pragma omp parallel for
+    for (int i = 0; i < current.size(); i++) {
+        for (int c = 0; c < 3; c++) {
+            this->inverseDiagonal[c][i] = current.isFixed(i) ? Real(0) : Real(1) / this->inverseDiagonal[c][i];
+        }
+    }
+}
+
+/**
+ * out = A * in, A = I - dt / m * df/dv - dt^2 / m * df/dx, rows of fixed points are zero
+ * @param Cube* cube - cube to integrate
+ * @param const ParticleStore <Real>& current - state the blocks were built at (fixed flags)
+ * @param Real* const in[3] - vector to multiply
+ * @param Real* const out[3] - product
+ */
+template <typename Real>
+void ImplicitEulerIntegrator<Real>::multiply(Cube* cube, const ParticleStore <Real>& current, Real* const in[3], Real* const out[3]) {
+    typedef glm::vec<3, Real> vec3;
+    const SpringTable& springs = cube->springs;
+
+    #pragma omp parallel for
+    for (int i = 0; i < current.size(); i++) {
+        const vec3 v = vec3(in[0][i], in[1][i], in[2][i]);
+        const vec3 n = vec3(this->contactNx[i], this->contactNy[i], this->contactNz[i]);
+        const vec3 y = v + this->contactAlong[i] * glm::dot(n, v) * n + this->contactAcross[i] * v;
+        out[0][i] = y.x; out[1][i] = y.y; out[2][i] = y.z;
+    }
+
+    springs.forEachColored([&](int s) {
+        const int a = springs.pointA[s];
+        const int b = springs.pointB[s];
+        const vec3 n = vec3(this->nx[s], this->ny[s], this->nz[s]);
+        const vec3 dv = vec3(in[0][a] - in[0][b], in[1][a] - in[1][b], in[2][a] - in[2][b]);
+        const vec3 y = (this->stiffnessAlong[s] + this->dampingAlong[s]) * glm::dot(n, dv) * n + this->stiffnessAcross[s] * dv;
+
+        out[0][a] += y.x; out[1][a] += y.y; out[2][a] += y.z;
+        out[0][b] -= y.x; out[1][b] -= y.y; out[2][b] -= y.z;
+    });
+
+    #pragma omp parallel for
+    for (int i = 0; i < current.size(); i++) {
+        if (current.isFixed(i)) {
+            out[0][i] = out[1][i] = out[2][i] = Real(0);
+        }
+    }
+}
+
+/**
+ * Jacobi preconditioned conjugate gradient, solves A * x = r for the velocity change x
+ * @param Cube* cube - cube to integrate
+ * @param const ParticleStore <Real>& current - state the system was assembled at
+ * @param int maxIterations - iteration cap
+ * @param double tolerance - stops once |residual| <= tolerance * |b|
+ * @return SolverStats - iterations run and relative residual reached
+ */
+template <typename Real>
+SolverStats ImplicitEulerIntegrator<Real>::solve(Cube* cube, const ParticleStore <Real>& current, int maxIterations, double tolerance) {
+    const int count = current.size();
+    SolverStats stats;
+
+    // x = 0, r = b, z = M^-1 r, d = z
+    #pragma omp parallel for
+    for (int i = 0; i < count; i++) {
+        for (int c = 0; c < 3; c++) {
+            this->x[c][i] = Real(0);
+            this->z[c][i] = this->inverseDiagonal[c][i] * this->r[c][i];
+            this->d[c][i] = this->z[c][i];
+        }
+    }
+
+    const double normB = std::sqrt(dot(this->r, this->r, count));
+    if (normB == 0.0) {
+        return stats;
+    }
+    double rz = dot(this->r, this->z, count);
+    stats.residual = 1.0;
+
+    while (stats.iterations < maxIterations && stats.residual > tolerance) {
+        this->multiply(cube, current, this->d, this->q);
+        const double dq = dot(this->d, this->q, count);
+        if (dq <= 0.0) {
+            // lost positive definiteness (degenerate spring), keep what we have
+            break;
+        }
+        const Real alpha = Real(rz / dq);
+
+        #pragma omp parallel for
+        for (int i = 0; i < count; i++) {
+            for (int c = 0; c < 3; c++) {
+                this->x[c][i] += alpha * this->d[c][i];
+                this->r[c][i] -= alpha * this->q[c][i];
+                this->z[c][i] = this->inverseDiagonal[c][i] * this->r[c][i];
+            }
+        }
+
+        stats.iterations++;
+        stats.residual = std::sqrt(dot(this->r, this->r, count)) / normB;
+
+        const double rzNext = dot(this->r, this->z, count);
+        const Real beta = Real(rzNext / rz);
+        rz = rzNext;
+
+        #pragma omp parallel for
+        for (int i = 0; i < count; i++) {
+            for (int c = 0; c < 3; c++) {
+                this->d[c][i] = this->z[c][i] + beta * this->d[c][i];
+            }
+        }
+    }
+
+    return stats;
+}
+
+/**
+ * performs one backward Euler step on the cube's particles
+ * v = v + dv, x = x + dt * v, dv from one linearised solve
+ * the iterations and residual of the solve are stored in cube->solverStats
+ * @param Cube* cube - cube to integrate
+ * @param double timeStep - dt
+ */
+template <typename Real>
+void ImplicitEulerIntegrator<Real>::step(Cube* cube, double timeStep) {
+    ParticleStore <Real>& current = cube->getParticles<Real>();
+    const Real dt = Real(timeStep);
+    this->prepare(cube, current);
+
+    // forces (springs, collision, external) at the current state
+    computeAcceleration <Real>(cube, current, timeStep);
+    this->assemble(cube, current, dt);
+    cube->solverStats = this->solve(cube, current, cube->solverIterations, double(cube->solverTolerance));
+
+    #pragma omp parallel for
+    for (int i = 0; i < current.size(); i++) {
+        if (current.isFixed(i) == true) {
+            // no change
+            continue;
+        }
+
+        current.vx[i] += this->x[0][i];
+        current.vy[i] += this->x[1][i];
+        current.vz[i] += this->x[2][i];
+
+        current.px[i] += current.vx[i] * dt;
+        current.py[i] += current.vy[i] * dt;
+        current.pz[i] += current.vz[i] * dt;
+    }
+}
+
+template class ImplicitEulerIntegrator <float>;
+template class ImplicitEulerIntegrator <double>;
@@ -0,0 +1,52 @@
+#ifndef __IMPLICITEULERINTEGRATOR_H__
+#define __IMPLICITEULERINTEGRATOR_H__
+
+#include "ParticleStore.h"
+
+class Cube;
+
+// result of the last linear solve, shown in the ui
+struct SolverStats {
+    int iterations = 0;
+    // relative residual |b - A dv| / |b|
+    double residual = 0.0;
+};
+
+// backward (implicit) Euler integrator, stays stable at large stiffness and frame rate time steps
+// solves the linearised step (M - dt * df/dv - dt^2 * df/dx) dv = dt * (f + dt * df/dx * v)
+// with a Jacobi preconditioned conjugate gradient, the matrix is never built:
+// every spring keeps its direction and coefficients and the product is evaluated spring by spring
+// Real is the precision of the particles it integrates
+template <typename Real>
+class ImplicitEulerIntegrator {
+
+    public:
+        ImplicitEulerIntegrator() {}; // default constructor
+
+        void step(Cube* cube, double timeStep);
+        void clear() { this->buffers.clear(); }
+
+    private:
+        // every buffer below
+        ParticleBuffers buffers{};
+
+        // per spring block of the system matrix, S = (stiffnessAlong + dampingAlong) * n n^T + stiffnessAcross * I
+        // the force Jacobian part (stiffness only) is also needed for the right hand side
+        Real *nx = nullptr, *ny = nullptr, *nz = nullptr;
+        Real *stiffnessAlong = nullptr, *dampingAlong = nullptr, *stiffnessAcross = nullptr;
+        // same block for the collision penalty spring of a point (rest length 0), zero when not in contact
+        Real *contactNx = nullptr, *contactNy = nullptr, *contactNz = nullptr;
+        Real *contactAlong = nullptr, *contactAcross = nullptr;
+
+        // conjugate gradient vectors, three arrays per vector
+        Real *x[3] = {}, *r[3] = {}, *z[3] = {}, *d[3] = {}, *q[3] = {};
+        // inverse of the diagonal of the system matrix (Jacobi preconditioner)
+        Real *inverseDiagonal[3] = {};
+
+        void prepare(Cube* cube, const ParticleStore <Real>& current);
+        void assemble(Cube* cube, const ParticleStore <Real>& current, Real timeStep);
+        void multiply(Cube* cube, const ParticleStore <Real>& current, Real* const in[3], Real* const out[3]);
+        SolverStats solve(Cube* cube, const ParticleStore <Real>& current, int maxIterations, double tolerance);
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "LatticeStencil.h"
+
+#include <glm/glm.hpp>
+
+void LatticeStencil::addOffset(int i, int j, int k, springTypeEnum type) {
+    const int maxRes = this->resolution > 1 ? this->resolution - 1 : 1;
+    const double restLength = glm::length(glm::dvec3(i, j, k)) / double(maxRes);
+
+    // same spring seen from both of its points
+    for (int sign = 1; sign >= -1; sign -= 2) {
+        this->di.push_back(sign * i);
+        this->dj.push_back(sign * j);
+        this->dk.push_back(sign * k);
+        // points are filled along the x axis first, then z then y
+        this->indexOffset.push_back(sign * ((j * this->resolution + k) * this->resolution + i));
+        this->restLength.push_back(restLength);
+        this->type.push_back(type);
+    }
+}
+
+/**
+ * fills the offsets for the enabled spring types, same springs as Cube::fillDiscretePoints
+ * @param int resolution - points per side of the lattice
+ * @param bool structural, shear, bend - enabled spring types
+ */
+void LatticeStencil::build(int resolution, bool structural, bool shear, bool bend) {
+    this->resolution = resolution;
+
+    this->di.clear();
+    this->dj.clear();
+    this->dk.clear();
+    this->indexOffset.clear();
+    this->restLength.clear();
+    this->type.clear();
+
+    if (structural) {
+        addOffset(1, 0, 0, STRUCTURAL);
+        addOffset(0, 1, 0, STRUCTURAL);
+        addOffset(0, 0, 1, STRUCTURAL);
+    }
+
+    if (shear) {
+        // face diagonals
+        addOffset(1, 1, 0, SHEAR);
+        addOffset(-1, 1, 0, SHEAR);
+        addOffset(0, 1, 1, SHEAR);
+        addOffset(0, -1, 1, SHEAR);
+        addOffset(1, 0, 1, SHEAR);
+        addOffset(-1, 0, 1, SHEAR);
+
+        // body diagonals
+        addOffset(1, 1, 1, SHEAR);
+        addOffset(-1, 1, 1, SHEAR);
+        addOffset(-1, -1, 1, SHEAR);
+        addOffset(1, -1, 1, SHEAR);
+    }
+
+    if (bend) {
+        addOffset(2, 0, 0, BEND);
+        addOffset(0, 2, 0, BEND);
+        addOffset(0, 0, 2, BEND);
+    }
+}
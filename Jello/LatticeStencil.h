@@ -0,0 +1,36 @@
+#ifndef __LATTICESTENCIL_H__
+#define __LATTICESTENCIL_H__
+
+#include <vector>
+
+#include "SpringTable.h"
+
+// fixed neighbor offsets of a point in the regular resolution^3 lattice
+// holds both directions of every spring so a point can gather all of its forces
+// without any per point connection storage
+class LatticeStencil {
+
+    public:
+        LatticeStencil() {}; // default constructor
+
+        void build(int resolution, bool structural, bool shear, bool bend);
+        int size() const { return int(this->di.size()); }
+
+        // offset along x, y, z (i, j, k)
+        std::vector <int> di{};
+        std::vector <int> dj{};
+        std::vector <int> dk{};
+        // offset in the particle store, pointIndex(i + di, j + dj, k + dk) - pointIndex(i, j, k)
+        // (only while the particles are in lattice order)
+        std::vector <int> indexOffset{};
+        // distance between the two points at rest
+        std::vector <double> restLength{};
+        // springTypeEnum of the offset
+        std::vector <int> type{};
+
+    private:
+        int resolution = 1;
+        void addOffset(int i, int j, int k, springTypeEnum type);
+};
+
+#endif
@@ -16,13 +16,18 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 #include <algorithm>
+#include <string>
 
 #include "InitShader.h"    //Functions for loading shaders from text files
 #include "trackball.h"
 #include "BoundingBox.h"
 #include "Physics.h"
+#include "SpringKernels.h"
 #include "Plate.h"
 #include "Cube.h"
+#include "Benchmark.h"
+#include "SimulationClock.h"
+#include "World.h"
 
 #include <glm/gtx/string_cast.hpp> // for debug
 
@@ -35,10 +40,18 @@ static const std::string debug_vertex_shader("debug_vs.glsl");
 static const std::string debug_fragment_shader("debug_fs.glsl");
 
 // SCENE
+World* world; // owns myCube (the first cube) and the extra jellos
 Cube* myCube;
 Plate* myPlate;
 BoundingBox* boundingBox;
+ColliderSet* colliders;
 glm::vec3 initPlatePos = glm::vec3(0.0f, 0.0f, 0.5f);
+// where the mouse drags the plate to, and where the plate was at the start of the frame's steps
+glm::vec3 plateTarget = initPlatePos;
+glm::vec3 plateFrameStart = initPlatePos;
+// where the plate starts and ends the current fixed step, substeps move it a linear share of the way each
+glm::vec3 plateStepStart = initPlatePos;
+glm::vec3 plateStepEnd = initPlatePos;
 glm::vec3 initCubePos = glm::vec3(-0.5f, 0.0f, 0.5f);
 glm::vec4 initCamPos = glm::vec4(0.0f, 2.5f, 5.0f, 1.0f); 
 
@@ -149,10 +162,13 @@ glm::vec3 gravity = glm::vec3(0.0, -9.8, 0.0); // acceleration
 bool addGravity = false;
 
 enum integratorEnum {
-    EULER, RK4
-}; // euler = 0 , RK4 = 1
+    EULER, RK4, IMPLICIT_EULER, VELOCITY_VERLET, ADAPTIVE_RK, XPBD, PROJECTIVE_DYNAMICS, POSITION_VERLET, MULTIRATE
+}; // euler (symplectic) = 0 , RK4 = 1, implicit euler = 2, velocity verlet = 3, adaptive RK = 4, XPBD = 5, projective dynamics = 6, position verlet = 7, multirate = 8
 int integrator = integratorEnum::EULER;
 
+// fixed steps of fTimeStep, as many per frame as the wall time of the frame holds
+SimulationClock simulationClock;
+
 // float values for it to be adjustable with ImGui
 float fTimeStep = 0.005f;
 int cubeResolution = 2;
@@ -160,6 +176,17 @@ bool cubeFixedFloor = true;
 bool cubeStructuralSpring = true;
 bool cubeShearSpring = true;
 bool cubeBendSpring = true;
+int cubeParticleOrder = ORDER_LATTICE;
+int cubePrecision = PRECISION_DOUBLE;
+
+// obstacles around the plate (physics only, not drawn)
+bool obstacleSphere = false;
+bool obstacleCapsule = false;
+bool obstacleBox = false;
+bool obstacleTorus = false; // baked into a distance grid
+
+// more jellos dropped into the box next to myCube, they collide with each other and with myCube
+int extraJellos = 0;
 
 bool needReset = false;
 bool needCamReset = false;
@@ -175,6 +202,56 @@ void clamp(float min, float max, float& value) {
     value = std::max(value, min);
 }
 
+// rebuilds the obstacles from the checkboxes
+void buildObstacles() {
+    colliders->clear();
+    if (obstacleSphere) {
+        colliders->addSphere(glm::dvec3(-1.6, 0.0, 0.0), 0.5);
+    }
+    if (obstacleCapsule) {
+        colliders->addCapsule(glm::dvec3(-1.0, 1.6, -0.6), glm::dvec3(1.0, 1.6, -0.6), 0.2);
+    }
+    if (obstacleBox) {
+        const glm::dmat3 rotation = glm::dmat3(glm::rotate(glm::dmat4(1.0), glm::radians(30.0), glm::dvec3(0.0, 1.0, 0.0)));
+        colliders->addBox(glm::dvec3(1.6, 0.0, 0.0), glm::dvec3(0.4, 0.5, 0.4), rotation);
+    }
+    if (obstacleTorus) {
+        // torus under the plate, major radius 0.8, minor radius 0.2
+        const glm::dvec3 center = glm::dvec3(0.0, -0.3, 0.0);
+        const double cellSize = 0.05;
+        const glm::dvec3 margin = glm::dvec3(1.0, 0.2, 1.0) + 2.0 * cellSize;
+        colliders->addGrid(GridCollider::bake(center - margin, center + margin, cellSize, [center](const glm::dvec3& point) {
+            const glm::dvec3 p = point - center;
+            const double ring = glm::length(glm::dvec2(p.x, p.z)) - 0.8;
+            return glm::length(glm::dvec2(ring, p.y)) - 0.2;
+        }));
+    }
+}
+
+// adds or removes extra jellos, new ones take the current jello values and start in a 5 x 5 grid above myCube
+void buildExtraJellos() {
+    world->resize(1 + extraJellos);
+    const int first = world->size() - 1;
+    for (int k = first; k < extraJellos; k++) {
+        // same frame as myCube, so the box and the obstacles act on them alike
+        Cube* cube = world->addCube(cubeResolution, initCubePos, shader_program, debug_shader_program);
+        cube->latticeOrigin = glm::vec3(-2.9f + 1.2f * float(k % 5), 1.5f, 1.9f - 1.2f * float(k / 5));
+        cube->structuralSpring = cubeStructuralSpring;
+        cube->shearSpring = cubeShearSpring;
+        cube->bendSpring = cubeBendSpring;
+        cube->fixedFloor = false;
+        cube->particleOrder = cubeParticleOrder;
+        cube->precision = cubePrecision;
+        cube->stiffness = myCube->stiffness;
+        std::copy(myCube->springTypeStiffness, myCube->springTypeStiffness + 3, cube->springTypeStiffness);
+        cube->damping = myCube->damping;
+        cube->mass = myCube->mass;
+        cube->sweptCollision = myCube->sweptCollision;
+        cube->sweptRestitution = myCube->sweptRestitution;
+        cube->reset();
+    }
+}
+
 /*
  * Draws the GUI with ImGui
  */
@@ -213,13 +290,75 @@ void draw_gui(GLFWwindow* window)
    ImGui::Checkbox("Shear Spring", &cubeShearSpring);
    ImGui::Checkbox("Bend Spring", &cubeBendSpring);
    ImGui::Checkbox("Add Gravity", &addGravity);
+   ImGui::Text("Particle Order");
+   ImGui::RadioButton("Lattice", &cubeParticleOrder, particleOrderEnum::ORDER_LATTICE); ImGui::SameLine();
+   ImGui::RadioButton("Morton", &cubeParticleOrder, particleOrderEnum::ORDER_MORTON);
+   ImGui::Text("Precision");
+   ImGui::RadioButton("Double", &cubePrecision, precisionEnum::PRECISION_DOUBLE); ImGui::SameLine();
+   ImGui::RadioButton("Float", &cubePrecision, precisionEnum::PRECISION_FLOAT);
+
+   // Obstacles
+   ImGui::Separator();
+   ImGui::Text("OBSTACLES");
+   bool obstaclesChanged = ImGui::Checkbox("Sphere", &obstacleSphere); ImGui::SameLine();
+   obstaclesChanged |= ImGui::Checkbox("Capsule", &obstacleCapsule);
+   obstaclesChanged |= ImGui::Checkbox("Box", &obstacleBox); ImGui::SameLine();
+   obstaclesChanged |= ImGui::Checkbox("Torus (Grid)", &obstacleTorus);
+   if (obstaclesChanged) {
+       buildObstacles();
+       for (int i = 0; i < world->size(); i++) {
+           world->getCube(i)->accelerationCurrent = false;
+       }
+   }
+   ImGui::Text("Points in contact: %d", colliders->getContactCount());
+
+   // World
+   ImGui::Separator();
+   ImGui::Text("WORLD");
+   if (ImGui::SliderInt("Extra Jellos", &extraJellos, 0, 24)) {
+       buildExtraJellos();
+   }
+   float contactThickness = float(world->contactThickness);
+   if (ImGui::SliderFloat("Contact Thickness", &contactThickness, 0.01f, 0.2f)) {
+       world->contactThickness = double(contactThickness);
+   }
+   ImGui::Text("Pairs: %d, points in contact: %d", world->getStats().pairs, world->getStats().contacts);
 
    // Physics
    ImGui::Separator();
    ImGui::Text("PHYSICS");
-   ImGui::SliderFloat("Stiffness", &myCube->stiffness, 0.0f, 2000.0f);
-   ImGui::SliderFloat("Damping", &myCube->damping, 0.0, 10.0f);
-   ImGui::SliderFloat("Mass", &myCube->mass, 1.0f, 50.0f); // cannot be 0
+   bool forcesChanged = ImGui::SliderFloat("Stiffness", &myCube->stiffness, 0.0f, 2000.0f);
+   forcesChanged |= ImGui::SliderFloat3("Structural / Shear / Bend", myCube->springTypeStiffness, 0.0f, 10.0f);
+   forcesChanged |= ImGui::SliderFloat("Damping", &myCube->damping, 0.0, 10.0f);
+   forcesChanged |= ImGui::SliderFloat("Mass", &myCube->mass, 1.0f, 50.0f); // cannot be 0
+   ImGui::Checkbox("Lattice Gather Forces", &myCube->latticeGather);
+   forcesChanged |= ImGui::Checkbox("Self Collision", &myCube->selfCollision);
+   if (myCube->selfCollision) {
+       forcesChanged |= ImGui::SliderFloat("Thickness (spacing)", &myCube->selfCollisionThickness, 0.05f, 0.5f);
+       ImGui::Text("Contacts: %d of %d surface points, %d triangles", myCube->selfCollisionStats.contacts,
+           myCube->selfCollisionStats.surfacePoints, myCube->selfCollisionStats.triangles);
+   }
+   if (forcesChanged) {
+       // accelerations kept by velocity Verlet were found with the old values
+       myCube->accelerationCurrent = false;
+   }
+   if (ImGui::Checkbox("Continuous Collision", &myCube->sweptCollision)) {
+       for (int c = 1; c < world->size(); c++) {
+           world->getCube(c)->sweptCollision = myCube->sweptCollision;
+       }
+   }
+   if (myCube->sweptCollision) {
+       if (ImGui::SliderFloat("Restitution", &myCube->sweptRestitution, 0.1f, 1.0f)) {
+           for (int c = 1; c < world->size(); c++) {
+               world->getCube(c)->sweptRestitution = myCube->sweptRestitution;
+           }
+       }
+       ImGui::Text("Impacts: %d points", myCube->sweptCollisionStats.impacts);
+   }
+   ImGui::Text("Spring Kernel (CPU supports %s)", getSimdLevelName(detectSimdLevel()));
+   ImGui::RadioButton("Scalar", &myCube->simdLevel, simdLevelEnum::SIMD_SCALAR); ImGui::SameLine();
+   ImGui::RadioButton("AVX2", &myCube->simdLevel, simdLevelEnum::SIMD_AVX2); ImGui::SameLine();
+   ImGui::RadioButton("AVX-512", &myCube->simdLevel, simdLevelEnum::SIMD_AVX512);
    needReset = ImGui::Button("Reset Simulation"); // reset simulation
 
    // Display
@@ -239,9 +378,70 @@ void draw_gui(GLFWwindow* window)
    // integrators
    ImGui::Separator();
    ImGui::Text("INTEGRATORS");
-   ImGui::RadioButton("Euler", &integrator, integratorEnum::EULER);
+   ImGui::RadioButton("Symplectic Euler", &integrator, integratorEnum::EULER);
+   ImGui::RadioButton("Velocity Verlet", &integrator, integratorEnum::VELOCITY_VERLET);
+   ImGui::RadioButton("Position Verlet (Stormer)", &integrator, integratorEnum::POSITION_VERLET);
    ImGui::RadioButton("RK4", &integrator, integratorEnum::RK4);
-   ImGui::SliderFloat("TimeStep", &fTimeStep, 0.001f, 0.01f);
+   ImGui::RadioButton("Implicit Euler", &integrator, integratorEnum::IMPLICIT_EULER);
+   ImGui::RadioButton("Adaptive RK (3/2)", &integrator, integratorEnum::ADAPTIVE_RK);
+   ImGui::RadioButton("Multirate Euler", &integrator, integratorEnum::MULTIRATE);
+   ImGui::RadioButton("XPBD", &integrator, integratorEnum::XPBD);
+   ImGui::RadioButton("Projective Dynamics", &integrator, integratorEnum::PROJECTIVE_DYNAMICS);
+   if (integrator == integratorEnum::IMPLICIT_EULER) {
+       // stable up to frame rate steps
+       ImGui::SliderFloat("TimeStep", &fTimeStep, 0.001f, 1.0f / 60.0f);
+       ImGui::SliderInt("CG Iterations", &myCube->solverIterations, 1, 500);
+       ImGui::SliderFloat("CG Tolerance", &myCube->solverTolerance, 1e-8f, 1e-1f, "%.1e", ImGuiSliderFlags_Logarithmic);
+       ImGui::Text("CG: %d iterations, residual %.2e", myCube->solverStats.iterations, myCube->solverStats.residual);
+   }
+   else if (integrator == integratorEnum::XPBD) {
+       // unconditionally stable, substeps and iterations trade cost for stiffness
+       ImGui::SliderFloat("TimeStep", &fTimeStep, 0.001f, 1.0f / 60.0f);
+       ImGui::SliderInt("Substeps", &myCube->xpbdSubsteps, 1, 32);
+       ImGui::SliderInt("Iterations", &myCube->xpbdIterations, 1, 50);
+   }
+   else if (integrator == integratorEnum::PROJECTIVE_DYNAMICS) {
+       // unconditionally stable, changing the time step refactors the system
+       ImGui::SliderFloat("TimeStep", &fTimeStep, 0.001f, 1.0f / 60.0f);
+       ImGui::SliderInt("Iterations", &myCube->pdIterations, 1, 50);
+       const ProjectiveDynamicsStats& stats = myCube->pdStats;
+       ImGui::Text("Factor: %d unknowns, %lld nonzeros (%d factorizations)", stats.unknowns, stats.nonZeros, stats.factorizations);
+   }
+   else if (integrator == integratorEnum::MULTIRATE) {
+       // the step only has to be stable for the springs, contacts and stiff springs are subcycled
+       clamp(0.001f, 0.01f, fTimeStep);
+       ImGui::SliderFloat("TimeStep", &fTimeStep, 0.001f, 0.01f);
+       ImGui::SliderInt("Fast Substeps", &myCube->multirateSubsteps, 1, 64);
+       ImGui::SliderFloat("Stiff Multiplier", &myCube->multirateStiffThreshold, 1.0f, 10.0f);
+       const MultirateStats& stats = myCube->multirateStats;
+       ImGui::Text("Fast: %d points, %d stiff springs", stats.fastPoints, stats.fastSprings);
+       ImGui::Text("Evaluations: %lld (%lld substepping everything)", stats.evaluations, stats.uniformEvaluations);
+   }
+   else if (integrator == integratorEnum::ADAPTIVE_RK) {
+       // time step is the fixed step of the simulation clock, the integrator picks its own steps inside each one
+       ImGui::SliderFloat("TimeStep", &fTimeStep, 0.001f, 1.0f / 60.0f);
+       ImGui::SliderFloat("Min Step", &myCube->adaptiveMinStep, 1e-6f, 1e-3f, "%.1e", ImGuiSliderFlags_Logarithmic);
+       ImGui::SliderFloat("Max Step", &myCube->adaptiveMaxStep, 1e-4f, 1.0f / 60.0f, "%.1e", ImGuiSliderFlags_Logarithmic);
+       ImGui::SliderFloat("Tolerance", &myCube->adaptiveTolerance, 1e-6f, 1e-1f, "%.1e", ImGuiSliderFlags_Logarithmic);
+       const StepHistory& history = myCube->stepHistory;
+       ImGui::PlotLines("Accepted Steps", history.steps, StepHistory::SIZE, history.next, nullptr, 0.0f, myCube->adaptiveMaxStep, ImVec2(0, 60));
+       ImGui::Text("Last frame: %d accepted, %d rejected", history.accepted, history.rejected);
+   }
+   else {
+       // substepping keeps frame rate steps stable, without it the step is held small
+       ImGui::Checkbox("Auto Substep", &myCube->autoSubstep);
+       const float maxStep = myCube->autoSubstep ? 1.0f / 60.0f : 0.01f;
+       clamp(0.001f, maxStep, fTimeStep);
+       ImGui::SliderFloat("TimeStep", &fTimeStep, 0.001f, maxStep);
+       if (myCube->autoSubstep) {
+           ImGui::SliderFloat("Safety", &myCube->stabilitySafety, 0.1f, 1.0f);
+           const StabilityLimit& limit = myCube->stabilityLimit;
+           ImGui::Text("Stable step %.2e s (omega %.0f rad/s), %d substeps", limit.stableStep, limit.omega, limit.substeps);
+       }
+   }
+   ImGui::SliderInt("Max Steps per Frame", &simulationClock.maxSubsteps, 1, 32);
+   ImGui::Checkbox("Interpolate Render", &simulationClock.interpolate);
+   ImGui::Text("Steps this frame: %d (%.2f s dropped)", simulationClock.getSteps(), simulationClock.getDroppedTime());
 
    ImGui::Separator();
    if (ImGui::Button("Quit"))
@@ -462,11 +662,15 @@ void DrawScene()
     glUseProgram(shader_program);
     // Pass 1: Draw cube back faces and store eye-space depth
     glUniform1i(UniformLocs::pass, BACK_FACES);
-    myCube->render(UniformLocs::M, showDiscrete, showSpring, debugMode);
+    for (int i = 0; i < world->size(); i++) {
+        world->getCube(i)->render(UniformLocs::M, showDiscrete, showSpring, debugMode);
+    }
 
     // Pass 2: Draw cube front faces
     glUniform1i(UniformLocs::pass, FRONT_FACES);
-    myCube->render(UniformLocs::M, showDiscrete, showSpring, debugMode);
+    for (int i = 0; i < world->size(); i++) {
+        world->getCube(i)->render(UniformLocs::M, showDiscrete, showSpring, debugMode);
+    }
 
     // Render textured quad to back buffer
     glUniform1i(UniformLocs::pass, QUAD);
@@ -493,7 +697,9 @@ void DrawScene()
         glViewport(0, 0, CameraData.resolution.x, CameraData.resolution.y);
 
         // draw points on top 
-        myCube->render(UniformLocs::M, showDiscrete, showSpring, debugMode);
+        for (int i = 0; i < world->size(); i++) {
+            world->getCube(i)->render(UniformLocs::M, showDiscrete, showSpring, debugMode);
+        }
 
         if (showBB) {
             // draw bounding box
@@ -541,12 +747,14 @@ void idle()
        clamp(0.0, double(CameraData.resolution.x), mouseX);
        glm::vec4 currentW;
        getWorld(glm::vec2(mouseX, mouseY), currentW);
-       myPlate->setPosition(glm::vec3(currentW.x, 0.0f, 0.0f), fTimeStep);
+       // the plate follows in stepPhysics, one move per fixed step
+       plateTarget = glm::vec3(currentW.x, 0.0f, 0.0f);
    }
 
    // reset button pressed or if values changed and needs to be resetted
    if (needReset || myCube->resolution != cubeResolution || myCube->structuralSpring != cubeStructuralSpring ||
-       myCube->shearSpring != cubeShearSpring || myCube->bendSpring != cubeBendSpring || myCube->fixedFloor != cubeFixedFloor) {
+       myCube->shearSpring != cubeShearSpring || myCube->bendSpring != cubeBendSpring || myCube->fixedFloor != cubeFixedFloor ||
+       myCube->particleOrder != cubeParticleOrder || myCube->precision != cubePrecision) {
        // reset simulation
        std::cout << "RESETTING" << std::endl;
 
@@ -556,13 +764,22 @@ void idle()
        myCube->shearSpring = cubeShearSpring;
        myCube->bendSpring = cubeBendSpring;
        myCube->fixedFloor = cubeFixedFloor;
+       myCube->particleOrder = cubeParticleOrder;
+       myCube->precision = cubePrecision;
        myCube->reset();
+       // old constraint indices do not match the new points, drop them before moving the plate back
+       myPlate->setConstraintPoints(myCube, std::vector <int>());
        myPlate->setPosition(initPlatePos, fTimeStep);
+       plateTarget = initPlatePos;
 
        // need to reconstrain since new masspoints are created
        if (myCube->fixedFloor) {
-           myPlate->setConstraintPoints(myCube->bottomFace);
+           myPlate->setConstraintPoints(myCube, myCube->bottomFace);
        }
+
+       // extra jellos start over with the new values
+       world->resize(1);
+       buildExtraJellos();
    }
 
     // camera
@@ -571,13 +788,94 @@ void idle()
         trackball = TrackBallC();
     }
    
-    // physics
-    myCube->setExternalForce(addGravity ? externalForce + gravity : externalForce);
-    externalForce *= forceDamping;
     glUniform1f(UniformLocs::time, time_sec);
 
 }
 
+/*
+ * Moves the plate to its position at the given share of the fixed step, only for the cube it holds
+ * timeStep - time since the last move, the velocity of the fixed points is the move over it
+ */
+void advancePlate(Cube* cube, double fraction, double timeStep)
+{
+    if (cube == myPlate->cube) {
+        myPlate->setPosition(glm::mix(plateStepStart, plateStepEnd, float(fraction)), timeStep);
+    }
+}
+
+/*
+ * Advances one cube by one fixed step of the selected integrator
+ */
+void integrateCube(Cube* cube, double timeStep)
+{
+    // explicit integrators are split into substeps below their stability limit
+    // (position Verlet is symplectic Euler with the velocity as a backward difference, same limit)
+    if (integrator == integratorEnum::EULER || integrator == integratorEnum::VELOCITY_VERLET || integrator == integratorEnum::POSITION_VERLET
+        || integrator == integratorEnum::RK4) {
+        const explicitMethodEnum method = integrator == integratorEnum::RK4 ? EXPLICIT_RK4
+            : (integrator == integratorEnum::VELOCITY_VERLET ? EXPLICIT_VELOCITY_VERLET : EXPLICIT_SYMPLECTIC_EULER);
+        const int substeps = cube->autoSubstep ? stableSubsteps(cube, method, timeStep) : 1;
+        const double substep = timeStep / double(substeps);
+
+        for (int s = 0; s < substeps; s++) {
+            // the plate moves with every substep, so position Verlet derives its true velocity each time
+            advancePlate(cube, double(s + 1) / double(substeps), substep);
+            if (integrator == integratorEnum::EULER) {
+                integrateEuler(cube, substep);
+            }
+            else if (integrator == integratorEnum::VELOCITY_VERLET) {
+                integrateVelocityVerlet(cube, substep);
+            }
+            else if (integrator == integratorEnum::POSITION_VERLET) {
+                integratePositionVerlet(cube, substep);
+            }
+            else {
+                integrateRK4(cube, substep);
+            }
+        }
+    }
+    else {
+        // the other integrators take the whole fixed step at once
+        advancePlate(cube, 1.0, timeStep);
+        if (integrator == integratorEnum::IMPLICIT_EULER) {
+            integrateImplicitEuler(cube, timeStep);
+        }
+        else if (integrator == integratorEnum::ADAPTIVE_RK) {
+            integrateAdaptive(cube, timeStep);
+        }
+        else if (integrator == integratorEnum::MULTIRATE) {
+            integrateMultirate(cube, timeStep);
+        }
+        else if (integrator == integratorEnum::XPBD) {
+            integrateXPBD(cube, timeStep);
+        }
+        else if (integrator == integratorEnum::PROJECTIVE_DYNAMICS) {
+            integrateProjectiveDynamics(cube, timeStep);
+        }
+    }
+}
+
+/*
+ * Runs one fixed step of the world: the plate moves on towards the drag target, contacts between the jellos,
+ * then the selected integrator on every one
+ * frameFraction - share of the frame's steps done at the end of this step, the plate reaches the target with the last
+ */
+void stepPhysics(double frameFraction)
+{
+    // the plate moves over this step in integrateCube, the velocity of the fixed points is the same at any frame rate
+    plateStepStart = myPlate->platePlane->getPosition();
+    plateStepEnd = glm::mix(plateFrameStart, plateTarget, float(frameFraction));
+
+    // the drag force decays per step, so it lasts the same simulated time at any frame rate, it only pulls myCube
+    for (int i = 0; i < world->size(); i++) {
+        const glm::vec3 force = world->getCube(i) == myCube ? externalForce : glm::vec3(0.0f);
+        world->getCube(i)->setExternalForce(addGravity ? force + gravity : force);
+    }
+    externalForce *= forceDamping;
+
+    world->step(double(fTimeStep), integrateCube);
+}
+
 void reload_shader()
 {
     GLuint new_shader = InitShader(vertex_shader.c_str(), fragment_shader.c_str());
@@ -755,12 +1053,15 @@ void initOpenGL()
 
 void buildScene() {
     // build scene
-    myCube = new Cube(2, initCubePos, shader_program, debug_shader_program); // initial cube resolution = 2 
+    world = new World();
+    myCube = world->addCube(2, initCubePos, shader_program, debug_shader_program); // initial cube resolution = 2 
     myCube->setSpringMode(true, true, true);
     boundingBox = new BoundingBox(6, 6, 6, glm::vec3(-3.0f, 5.5f, 3.0f), debug_shader_program);
+    colliders = new ColliderSet();
+    buildObstacles();
     myPlate = new Plate(initPlatePos, 2.0, debug_shader_program);
     if (myCube->fixedFloor) {
-        myPlate->setConstraintPoints(myCube->bottomFace);
+        myPlate->setConstraintPoints(myCube, myCube->bottomFace);
     }
 }
  
@@ -804,6 +1105,13 @@ int main(int argc, char **argv){
     initOpenGL();
     buildScene();
 
+    // headless timing runs, print the results and quit
+    if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+        runBenchmark();
+        glfwTerminate();
+        return 0;
+    }
+
     //Init ImGui
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -815,11 +1123,19 @@ int main(int argc, char **argv){
     {
         idle();
 
-        if (integrator == integratorEnum::EULER) {
-            integrateEuler(myCube, double(fTimeStep));
+        // fixed steps for the wall time of this frame, the render blends the last two
+        const int steps = simulationClock.advance(glfwGetTime(), double(fTimeStep));
+        plateFrameStart = myPlate->platePlane->getPosition();
+        for (int s = 0; s < steps; s++) {
+            if (s == steps - 1) {
+                for (int i = 0; i < world->size(); i++) {
+                    world->getCube(i)->storePreviousState();
+                }
+            }
+            stepPhysics(double(s + 1) / double(steps));
         }
-        else if (integrator == integratorEnum::RK4) {
-            integrateRK4(myCube, double(fTimeStep));
+        for (int i = 0; i < world->size(); i++) {
+            world->getCube(i)->renderBlend = float(simulationClock.getBlend(double(fTimeStep)));
         }
 
         display(window);
@@ -0,0 +1,222 @@
+#include "MultirateIntegrator.h"
+#include "Physics.h"
+
+#include <algorithm>
+
+// drops the buffers and the stiff springs, the next topology finds them again
+template <typename Real>
+void MultirateIntegrator<Real>::clear() {
+    this->buffers.clear();
+    this->threshold = -1.0f;
+}
+
+/**
+ * lays out the buffers for the current topology and lists the stiff springs of every point
+ * @param Cube* cube - cube to integrate
+ * @param const ParticleStore <Real>& p - the cube's particles
+ */
+template <typename Real>
+void MultirateIntegrator<Real>::prepare(Cube* cube, const ParticleStore <Real>& p) {
+    const SpringTable& springs = cube->springs;
+    const int count = p.size();
+    const bool sized = this->buffers.fits(count, springs.size());
+
+    bool found = sized && this->threshold == cube->multirateStiffThreshold;
+    for (int t = 0; t < SPRING_TYPE_COUNT; t++) {
+        found = found && this->typeStiffness[t] == cube->springTypeStiffness[t];
+    }
+    if (found) {
+        return;
+    }
+
+    if (!sized) {
+        Arena& arena = this->buffers.resize(count, springs.size(), 2 * Arena::bytesFor<int>(count + 1) + Arena::bytesFor<int>(2 * size_t(springs.size()))
+            + 3 * Arena::bytesFor<Real>(count) + Arena::bytesFor<uint8_t>(count));
+        this->stiffOffsets = arena.allocate<int>(count + 1);
+        this->stiffSprings = arena.allocate<int>(2 * size_t(springs.size()));
+        this->fastPoints = arena.allocate<int>(count + 1);
+        this->fastX = arena.allocate<Real>(count);
+        this->fastY = arena.allocate<Real>(count);
+        this->fastZ = arena.allocate<Real>(count);
+        this->fastFlag = arena.allocate<uint8_t>(count);
+        std::fill(this->fastFlag, this->fastFlag + count, uint8_t(0));
+    }
+
+    // count, prefix sum, fill
+    std::fill(this->stiffOffsets, this->stiffOffsets + count + 1, 0);
+    this->stiffCount = 0;
+    for (int s = 0; s < springs.size(); s++) {
+        if (cube->springTypeStiffness[springs.type[s]] > cube->multirateStiffThreshold) {
+            this->stiffOffsets[springs.pointA[s] + 1]++;
+            this->stiffOffsets[springs.pointB[s] + 1]++;
+            this->stiffCount++;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        this->stiffOffsets[i + 1] += this->stiffOffsets[i];
+    }
+    // fastPoints is free until the step, it holds the next free slot per point here
+    int* next = this->fastPoints;
+    std::copy(this->stiffOffsets, this->stiffOffsets + count, next);
+    for (int s = 0; s < springs.size(); s++) {
+        if (cube->springTypeStiffness[springs.type[s]] > cube->multirateStiffThreshold) {
+            this->stiffSprings[next[springs.pointA[s]]++] = s;
+            this->stiffSprings[next[springs.pointB[s]]++] = s;
+        }
+    }
+
+    this->threshold = cube->multirateStiffThreshold;
+    for (int t = 0; t < SPRING_TYPE_COUNT; t++) {
+        this->typeStiffness[t] = cube->springTypeStiffness[t];
+    }
+}
+
+/**
+ * lists the free points that need the fine step: on a stiff spring, in contact with a wall or an obstacle,
+ * or moving out of the box or into an obstacle within the coarse step at their current velocity
+ * @param const ParticleStore <Real>& p - the cube's particles
+ * @param double timeStep - coarse step
+ */
+template <typename Real>
+void MultirateIntegrator<Real>::findFastPoints(const ParticleStore <Real>& p, double timeStep) {
+    const bool obstacles = colliders != nullptr && !colliders->empty();
+    this->fastCount = 0;
+    for (int i = 0; i < p.size(); i++) {
+        if (p.isFixed(i)) {
+            continue;
+        }
+        const glm::dvec3 position = glm::dvec3(p.getPosition(i));
+        const glm::dvec3 predicted = position + glm::dvec3(p.getVelocity(i)) * timeStep;
+        const bool stiff = this->stiffOffsets[i + 1] > this->stiffOffsets[i];
+        glm::dvec3 normal;
+        const bool contact = !isPointInBox(position, boundingBox) || !isPointInBox(predicted, boundingBox)
+            || (obstacles && (colliders->distance(position, normal) <= 0.0 || colliders->distance(predicted, normal) <= 0.0));
+        if (stiff || contact) {
+            this->fastPoints[this->fastCount++] = i;
+            this->fastFlag[i] = 1;
+        }
+    }
+}
+
+/**
+ * acceleration of the fast forces at every fast point: its wall and obstacle contacts and its stiff springs
+ * @param Cube* cube - cube to integrate
+ * @param const ParticleStore <Real>& p - the cube's particles
+ */
+template <typename Real>
+void MultirateIntegrator<Real>::computeFastAcceleration(Cube* cube, const ParticleStore <Real>& p) {
+    typedef glm::vec<3, Real> vec3;
+    const SpringTable& springs = cube->springs;
+    const Real* restLength = springs.getRestLength<Real>();
+    const Real mass = Real(cube->mass);
+    const Real damping = Real(cube->damping);
+    const bool obstacles = colliders != nullptr && !colliders->empty();
+
+    Real kh[SPRING_TYPE_COUNT];
+    for (int t = 0; t < SPRING_TYPE_COUNT; t++) {
+        kh[t] = Real(cube->stiffness) * Real(cube->springTypeStiffness[t]);
+    }
+
+    #pragma omp parallel for
+    for (int f = 0; f < this->fastCount; f++) {
+        const int i = this->fastPoints[f];
+        const vec3 position = p.getPosition(i);
+        const vec3 velocity = p.getVelocity(i);
+        glm::dvec3 contact = computeContactAcceleration(cube, glm::dvec3(position), glm::dvec3(velocity));
+        if (obstacles) {
+            contact += colliders->contactAcceleration(cube, glm::dvec3(position), glm::dvec3(velocity));
+        }
+        vec3 acceleration = vec3(contact);
+
+        // every stiff spring from this point's side
+        vec3 force = vec3(0);
+        for (int n = this->stiffOffsets[i]; n < this->stiffOffsets[i + 1]; n++) {
+            const int s = this->stiffSprings[n];
+            const int other = springs.pointA[s] == i ? springs.pointB[s] : springs.pointA[s];
+            const vec3 otherPosition = p.getPosition(other);
+            force += calculateSpringForce <Real>(kh[springs.type[s]], position, otherPosition, restLength[s]);
+            force += calculateDampingForce <Real>(damping, position, otherPosition, velocity, p.getVelocity(other));
+        }
+        acceleration += force / mass;
+
+        this->fastX[f] = acceleration.x;
+        this->fastY[f] = acceleration.y;
+        this->fastZ[f] = acceleration.z;
+    }
+}
+
+/**
+ * performs one multirate step on the cube's particles, fast points take cube->multirateSubsteps fine steps
+ * @param Cube* cube - cube to integrate
+ * @param double timeStep - coarse step
+ */
+template <typename Real>
+void MultirateIntegrator<Real>::step(Cube* cube, double timeStep) {
+    ParticleStore <Real>& p = cube->getParticles<Real>();
+    const int substeps = std::max(1, cube->multirateSubsteps);
+    const Real H = Real(timeStep);
+    const Real h = Real(timeStep / double(substeps));
+    this->prepare(cube, p);
+
+    // every force once, then the fast part at the same state to split it off
+    computeAcceleration <Real>(cube, p, timeStep);
+    this->findFastPoints(p, timeStep);
+    this->computeFastAcceleration(cube, p);
+
+    // slow points kick and drift the whole step (symplectic Euler)
+    #pragma omp parallel for
+    for (int i = 0; i < p.size(); i++) {
+        if (p.isFixed(i) == true || this->fastFlag[i] != 0) {
+            continue;
+        }
+        p.vx[i] += p.ax[i] * H;
+        p.vy[i] += p.ay[i] * H;
+        p.vz[i] += p.az[i] * H;
+
+        p.px[i] += p.vx[i] * H;
+        p.py[i] += p.vy[i] * H;
+        p.pz[i] += p.vz[i] * H;
+    }
+
+    // fast points kick with the slow part of their acceleration for the whole step ...
+    #pragma omp parallel for
+    for (int f = 0; f < this->fastCount; f++) {
+        const int i = this->fastPoints[f];
+        p.vx[i] += (p.ax[i] - this->fastX[f]) * H;
+        p.vy[i] += (p.ay[i] - this->fastY[f]) * H;
+        p.vz[i] += (p.az[i] - this->fastZ[f]) * H;
+    }
+
+    // ... and subcycle their fast forces, the slow points hold their end of step positions meanwhile
+    for (int k = 0; k < substeps; k++) {
+        this->computeFastAcceleration(cube, p);
+
+        #pragma omp parallel for
+        for (int f = 0; f < this->fastCount; f++) {
+            const int i = this->fastPoints[f];
+            p.vx[i] += this->fastX[f] * h;
+            p.vy[i] += this->fastY[f] * h;
+            p.vz[i] += this->fastZ[f] * h;
+
+            p.px[i] += p.vx[i] * h;
+            p.py[i] += p.vy[i] * h;
+            p.pz[i] += p.vz[i] * h;
+        }
+    }
+
+    // one full evaluation and substeps + 1 fast ones (a contact and the stiff springs of every fast point)
+    long long fastEvaluations = this->fastCount;
+    for (int f = 0; f < this->fastCount; f++) {
+        const int i = this->fastPoints[f];
+        fastEvaluations += this->stiffOffsets[i + 1] - this->stiffOffsets[i];
+        this->fastFlag[i] = 0;
+    }
+    MultirateStats& stats = cube->multirateStats;
+    stats.fastPoints = this->fastCount;
+    stats.fastSprings = this->stiffCount;
+    stats.evaluations = (long long)(cube->springs.size()) + p.size() + (substeps + 1) * fastEvaluations;
+    stats.uniformEvaluations = (long long)(substeps) * ((long long)(cube->springs.size()) + p.size());
+}
+
+template class MultirateIntegrator <float>;
+template class MultirateIntegrator <double>;
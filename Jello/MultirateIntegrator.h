@@ -0,0 +1,60 @@
+#ifndef __MULTIRATEINTEGRATOR_H__
+#define __MULTIRATEINTEGRATOR_H__
+
+#include "ParticleStore.h"
+#include "SpringTable.h"
+
+class Cube;
+
+// what the last multirate step split off, shown in the ui
+struct MultirateStats {
+    // points subcycled (in or about to be in wall contact, or on a stiff spring) and stiff springs
+    int fastPoints = 0;
+    int fastSprings = 0;
+    // force evaluations (springs and contacts) of the step, and what substepping the whole cube would cost
+    long long evaluations = 0;
+    long long uniformEvaluations = 0;
+};
+
+// multirate symplectic Euler (impulse method): the forces are split into slow ones, springs and the external force,
+// and fast ones, the wall contacts and springs of a type whose stiffness multiplier is above a threshold
+// every coarse step evaluates all forces once, the slow part is the total minus the fast part at the start of the step
+// points without fast forces kick with it and drift for the whole step, points with fast forces kick with the
+// slow part and then subcycle only their fast forces at the fine step, every coarse step synchronizes the two
+// again (the slow forces of the next step see where the fast points ended)
+// a point is fast while it is in contact, would reach a wall within the coarse step, or ends a stiff spring
+// the stiff springs are found again when a type multiplier or the threshold changes
+// Real is the precision of the particles it integrates
+template <typename Real>
+class MultirateIntegrator {
+
+    public:
+        MultirateIntegrator() {}; // default constructor
+
+        void step(Cube* cube, double timeStep);
+        void clear();
+
+    private:
+        // every buffer below
+        ParticleBuffers buffers{};
+        // stiffness multipliers and threshold the stiff springs were found for
+        float typeStiffness[SPRING_TYPE_COUNT] = {};
+        float threshold = -1.0f;
+
+        // stiff springs of every point in compressed sparse rows, both endpoints list the spring
+        int* stiffOffsets = nullptr;
+        int* stiffSprings = nullptr;
+        int stiffCount = 0;
+        // fast points of the current step, and 1 per fast point (0 again after the step)
+        int* fastPoints = nullptr;
+        int fastCount = 0;
+        uint8_t* fastFlag = nullptr;
+        // fast acceleration of every fast point (indexed like fastPoints)
+        Real *fastX = nullptr, *fastY = nullptr, *fastZ = nullptr;
+
+        void prepare(Cube* cube, const ParticleStore <Real>& p);
+        void findFastPoints(const ParticleStore <Real>& p, double timeStep);
+        void computeFastAcceleration(Cube* cube, const ParticleStore <Real>& p);
+};
+
+#endif
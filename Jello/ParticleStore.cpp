@@ -0,0 +1,97 @@
+#include "ParticleStore.h"
+
+#include <algorithm>
+
+// arena bytes for a store of count points
+template <typename Real>
+size_t ParticleStore<Real>::bytesFor(int count) {
+    const size_t words = (count + 63) / 64;
+    return 12 * Arena::bytesFor<Real>(count + STAGGER) + 2 * Arena::bytesFor<uint64_t>(words);
+}
+
+/**
+ * takes the arrays for count points from the arena, every value starts at 0
+ * @param Arena& arena - arena with at least bytesFor(count) left
+ * @param int count - number of points
+ */
+template <typename Real>
+void ParticleStore<Real>::allocate(Arena& arena, int count) {
+    this->count = count;
+
+    // arrays of a power of two size would start at the same cache set and evict each other
+    // when one point is read from all of them, one extra cache line per array shifts the next one
+    Real** arrays[12] = { &px, &py, &pz, &vx, &vy, &vz, &ax, &ay, &az, &rx, &ry, &rz };
+    for (Real** array : arrays) {
+        *array = arena.allocate<Real>(count + STAGGER);
+        std::fill(*array, *array + count, Real(0));
+    }
+
+    // round up to whole 64 bit words
+    this->words = (count + 63) / 64;
+    fixedBits = arena.allocate<uint64_t>(words);
+    surfaceBits = arena.allocate<uint64_t>(words);
+    std::fill(fixedBits, fixedBits + words, 0);
+    std::fill(surfaceBits, surfaceBits + words, 0);
+}
+
+// forgets the arrays, the arena they came from releases the memory
+template <typename Real>
+void ParticleStore<Real>::clear() {
+    this->count = 0;
+    this->words = 0;
+
+    Real** arrays[12] = { &px, &py, &pz, &vx, &vy, &vz, &ax, &ay, &az, &rx, &ry, &rz };
+    for (Real** array : arrays) {
+        *array = nullptr;
+    }
+    fixedBits = nullptr;
+    surfaceBits = nullptr;
+}
+
+template <typename Real>
+void ParticleStore<Real>::initPoint(int i, vec3 position, bool isSurfacePoint) {
+    this->setPosition(i, position);
+    this->setVelocity(i, vec3(0));
+    this->setAcceleration(i, vec3(0));
+
+    rx[i] = position.x;
+    ry[i] = position.y;
+    rz[i] = position.z;
+
+    const uint64_t bit = uint64_t(1) << (i & 63);
+    if (isSurfacePoint) {
+        surfaceBits[i >> 6] |= bit;
+    }
+    else {
+        surfaceBits[i >> 6] &= ~bit;
+    }
+    fixedBits[i >> 6] &= ~bit;
+}
+
+template <typename Real>
+void ParticleStore<Real>::setFixed(int i, bool fixed) {
+    const uint64_t bit = uint64_t(1) << (i & 63);
+    if (fixed) {
+        fixedBits[i >> 6] |= bit;
+    }
+    else {
+        fixedBits[i >> 6] &= ~bit;
+    }
+}
+
+// fixed and surface bits of a store with the same point count
+template <typename Real>
+void ParticleStore<Real>::copyFlags(const ParticleStore& other) {
+    std::copy(other.fixedBits, other.fixedBits + words, fixedBits);
+    std::copy(other.surfaceBits, other.surfaceBits + words, surfaceBits);
+}
+
+template <typename Real>
+void ParticleStore<Real>::resetAcceleration() {
+    std::fill(ax, ax + count, Real(0));
+    std::fill(ay, ay + count, Real(0));
+    std::fill(az, az + count, Real(0));
+}
+
+template class ParticleStore <float>;
+template class ParticleStore <double>;
@@ -0,0 +1,73 @@
+#ifndef __PARTICLESTORE_H__
+#define __PARTICLESTORE_H__
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+#include "Arena.h"
+
+// mass points of a cube stored as a structure of arrays
+// each component lives in its own contiguous array so the physics loops
+// stream through memory by index instead of chasing pointers
+// the arrays live in an arena owned by whoever builds the store, the store itself owns no memory
+// Real is the scalar of the simulation (float or double), instantiated for both in ParticleStore.cpp
+template <typename Real>
+class ParticleStore {
+
+    public:
+        typedef glm::vec<3, Real> vec3;
+
+        ParticleStore() {}; // default constructor
+        // copies would alias the same arena memory
+        ParticleStore(const ParticleStore&) = delete;
+        ParticleStore& operator=(const ParticleStore&) = delete;
+
+        // padding (elements) after every array, one cache line
+        static const int STAGGER = 64 / sizeof(Real);
+
+        // setup
+        static size_t bytesFor(int count);
+        void allocate(Arena& arena, int count);
+        void clear();
+        void initPoint(int i, vec3 position, bool isSurfacePoint);
+        int size() const { return this->count; }
+
+        // Set
+        void setPosition(int i, vec3 position) { px[i] = position.x; py[i] = position.y; pz[i] = position.z; }
+        void setVelocity(int i, vec3 velocity) { vx[i] = velocity.x; vy[i] = velocity.y; vz[i] = velocity.z; }
+        void setAcceleration(int i, vec3 acceleration) { ax[i] = acceleration.x; ay[i] = acceleration.y; az[i] = acceleration.z; }
+        void addAcceleration(int i, vec3 acc) { ax[i] += acc.x; ay[i] += acc.y; az[i] += acc.z; }
+        void setFixed(int i, bool fixed);
+        void copyFlags(const ParticleStore& other);
+
+        // Get
+        vec3 getPosition(int i) const { return vec3(px[i], py[i], pz[i]); }
+        vec3 getVelocity(int i) const { return vec3(vx[i], vy[i], vz[i]); }
+        vec3 getAcceleration(int i) const { return vec3(ax[i], ay[i], az[i]); }
+        vec3 getInitialPosition(int i) const { return vec3(rx[i], ry[i], rz[i]); }
+
+        // Get (Boolean Status)
+        bool isFixed(int i) const { return (fixedBits[i >> 6] >> (i & 63)) & 1u; }
+        bool isSurfacePoint(int i) const { return (surfaceBits[i >> 6] >> (i & 63)) & 1u; }
+
+        // Process
+        void resetAcceleration();
+
+        // position
+        Real *px = nullptr, *py = nullptr, *pz = nullptr;
+        // velocity
+        Real *vx = nullptr, *vy = nullptr, *vz = nullptr;
+        // accumulated acceleration
+        Real *ax = nullptr, *ay = nullptr, *az = nullptr;
+        // rest (initial) position
+        Real *rx = nullptr, *ry = nullptr, *rz = nullptr;
+
+    private:
+        int count = 0;
+        // one bit per point, 64 points per word
+        int words = 0;
+        uint64_t* fixedBits = nullptr;
+        uint64_t* surfaceBits = nullptr;
+};
+
+#endif
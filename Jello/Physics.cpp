@@ -1,15 +1,18 @@
 #include "Physics.h"
+#include "SpringKernels.h"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 
 // COLLISION 
 bool isPointInNegativeSide(const glm::dvec3& point, const Plane& plane){
     return glm::dot(plane.normal, point) - glm::dot(plane.normal, plane.pointInPlane) < 0;
 }
 
-bool isPointInBox(glm::dvec3* const point, BoundingBox* const bbox) {
-    return ((point->x >= bbox->minX && point->x <= bbox->maxX)
-        && (point->y >= bbox->minY && point->y <= bbox->maxY)
-        && (point->z >= bbox->minZ && point->z <= bbox->maxZ));
+bool isPointInBox(const glm::dvec3& point, BoundingBox* const bbox) {
+    return ((point.x >= bbox->minX && point.x <= bbox->maxX)
+        && (point.y >= bbox->minY && point.y <= bbox->maxY)
+        && (point.z >= bbox->minZ && point.z <= bbox->maxZ));
 }
 
 /**
@@ -20,334 +23,741 @@ bool isPointInBox(glm::dvec3* const point, BoundingBox* const bbox) {
  */
 // NOTE: this will only work for boudning box and not other cubes inside the box
 // because theres no boundaries > only checking if inside
-glm::dvec3 computeClosestPoint(const glm::dvec3& point, Plane plane)
+glm::dvec3 computeClosestPoint(const glm::dvec3& point, const Plane& plane)
 {
     // create a ray with origin at pt, with -n direction and parameter t: r = pt - nt
-    // compute t when ray intersect with plane ax + by + cz + d = 0
+    // compute t when ray intersect with plane ax + by + cz + d = 0, d = -<n,pointInPlane>
     // t = (<n,pt>+d)/<n,n>
     double length2 = glm::dot(plane.normal, plane.normal); 
     double dot0 = glm::dot(plane.normal, point);
 
-    double t = (dot0 + glm::dot(plane.normal, plane.pointInPlane)) / length2;
+    double t = (dot0 - glm::dot(plane.normal, plane.pointInPlane)) / length2;
 
     // insert t back into ray equation we get intersection point : p1 = pt - tn
     return plane.normal * (-t) + point;
 }
 
-bool checkCollision(MassPoint* massPoint, BoundingBox* const bbox, glm::dvec3& closesPoint) {
+bool checkCollision(const glm::dvec3& pos, BoundingBox* const bbox, glm::dvec3& closesPoint) {
     // for mass points in cube, check if in boundingbox
     // if not inside, check if colliding 
-    // only gives one collision point per point, 
-    // if point hits two planes at once (ie: corner) it'll process one at a time
+    // the point is projected onto every plane it went through, so at an edge or corner
+    // the closest point is the edge or corner itself and the contact resolves in one step
 
-    glm::dvec3* const pos = massPoint->getPosition(); // already world space
+    // pos is already world space
 
     if (!isPointInBox(pos, bbox)) {
         // collide 
         // check for collision with each plane in box
+        bool collided = false;
+        closesPoint = pos;
         for (int p = 0; p < 6; p++) {
-            if (isPointInNegativeSide(*pos, *bbox->planes[p])) {
+            const Plane& plane = *bbox->planes[p];
+            if (isPointInNegativeSide(closesPoint, plane)) {
                 // find intersection point in plane 
-                // store mass point, closest point of collision, list of collision springs to process 
-                closesPoint = computeClosestPoint(*pos, *bbox->planes[p]);
-                return true;
+                closesPoint = computeClosestPoint(closesPoint, plane);
+                collided = true;
             }
         }
+        return collided;
     }
 
     return false;
 }
 
-void processCollisionResponse(Cube* const cube, MassPoint* const massPoint, const glm::dvec3& closestPoint) {
-    // compute elastic force and damping
-    glm::dvec3 springForce = calculateSpringForce(cube->stiffness, *(massPoint->getPosition()), closestPoint, 0.0);
-    glm::dvec3 dampingForce = calculateDampingForce(cube->damping * 50.0, *(massPoint->getPosition()), closestPoint, *(massPoint->getVelocity()), glm::dvec3(0.0));
+/**
+ * time of impact of a point moving on a straight line with the walls of the (axis aligned) bounding box,
+ * a wall the point starts outside of is left to the penalty response
+ * @param const glm::dvec3& from, const glm::dvec3& to - start and end of the line
+ * @param BoundingBox* const bbox - the walls
+ * @param glm::dvec3& normal - inward normal of the wall hit first
+ * @return double - fraction of the line at the impact, larger than 1 without one
+ */
+double sweepBox(const glm::dvec3& from, const glm::dvec3& to, BoundingBox* const bbox, glm::dvec3& normal) {
+    if (bbox == nullptr) {
+        return 2.0;
+    }
+    const glm::dvec3 lower = glm::dvec3(bbox->minX, bbox->minY, bbox->minZ);
+    const glm::dvec3 upper = glm::dvec3(bbox->maxX, bbox->maxY, bbox->maxZ);
+
+    double first = 2.0;
+    for (int axis = 0; axis < 3; axis++) {
+        double t = 2.0;
+        double direction = 0.0;
+        if (to[axis] < lower[axis] && from[axis] >= lower[axis]) {
+            t = (lower[axis] - from[axis]) / (to[axis] - from[axis]);
+            direction = 1.0;
+        }
+        else if (to[axis] > upper[axis] && from[axis] <= upper[axis]) {
+            t = (upper[axis] - from[axis]) / (to[axis] - from[axis]);
+            direction = -1.0;
+        }
+        if (t < first) {
+            first = t;
+            normal = glm::dvec3(0.0);
+            normal[axis] = direction;
+        }
+    }
+    return first;
+}
+
+/**
+ * contact with the walls of the (axis aligned) bounding box for every point in one sweep, plus the external force
+ * the closest point of the box is the position clamped to its extents, which covers faces, edges and corners alike
+ * rest length 0 spring towards it with 50 times the damping, like processCollisionResponse
+ * no branches: points inside have 0 penetration and get 0 contact, fixed points are masked out of the external force
+ * @param Cube* const cube - cube with stiffness, damping, mass and external force
+ * @param ParticleStore <Real>& particles - particle state to read and accumulate into
+ */
+template <typename Real>
+void computeBoxContactAcceleration(Cube* const cube, ParticleStore <Real>& particles) {
+    const Real minX = Real(boundingBox->minX), maxX = Real(boundingBox->maxX);
+    const Real minY = Real(boundingBox->minY), maxY = Real(boundingBox->maxY);
+    const Real minZ = Real(boundingBox->minZ), maxZ = Real(boundingBox->maxZ);
+
+    const Real invMass = Real(1) / Real(cube->mass);
+    const Real stiffness = Real(cube->stiffness) * invMass;
+    const Real damping = Real(cube->damping) * Real(50) * invMass;
+    const Real externalX = Real(cube->externalForce.x) * invMass;
+    const Real externalY = Real(cube->externalForce.y) * invMass;
+    const Real externalZ = Real(cube->externalForce.z) * invMass;
+
+    const Real* px = particles.px; const Real* py = particles.py; const Real* pz = particles.pz;
+    const Real* vx = particles.vx; const Real* vy = particles.vy; const Real* vz = particles.vz;
+    Real* ax = particles.ax; Real* ay = particles.ay; Real* az = particles.az;
+    const int count = particles.size();
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < count; i++) {
+        // penetration, 0 inside the box (selects instead of std::min / std::max, which take the address)
+        const Real x = px[i], y = py[i], z = pz[i];
+        const Real dx = x < minX ? x - minX : (x > maxX ? x - maxX : Real(0));
+        const Real dy = y < minY ? y - minY : (y > maxY ? y - maxY : Real(0));
+        const Real dz = z < minZ ? z - minZ : (z > maxZ ? z - maxZ : Real(0));
+        const Real depth2 = dx * dx + dy * dy + dz * dz;
+        const Real inverseDepth2 = depth2 > Real(0) ? Real(1) / depth2 : Real(0);
+
+        // -k * L - kd * (v . L) / |L|^2 * L, per unit mass
+        const Real contact = -stiffness - damping * (vx[i] * dx + vy[i] * dy + vz[i] * dz) * inverseDepth2;
+        const Real free = particles.isFixed(i) ? Real(0) : Real(1);
+
+        ax[i] += contact * dx + free * externalX;
+        ay[i] += contact * dy + free * externalY;
+        az[i] += contact * dz + free * externalZ;
+    }
+}
+
+template void computeBoxContactAcceleration <float>(Cube* const cube, ParticleStore <float>& particles);
+template void computeBoxContactAcceleration <double>(Cube* const cube, ParticleStore <double>& particles);
+
+/**
+ * acceleration of a point pushed back towards the closest point of the wall (or obstacle) it went through
+ * @param Cube* const cube - cube with stiffness, damping and mass
+ * @param const glm::dvec3& position, const glm::dvec3& velocity - state of the point
+ * @param const glm::dvec3& closestPoint - closest point on the wall
+ * @return glm::dvec3 - contact acceleration
+ */
+glm::dvec3 contactAcceleration(Cube* const cube, const glm::dvec3& position, const glm::dvec3& velocity, const glm::dvec3& closestPoint) {
+    // compute elastic force and damping, in double for both precisions
+    glm::dvec3 springForce = calculateSpringForce <double>(cube->stiffness, position, closestPoint, 0.0);
+    glm::dvec3 dampingForce = calculateDampingForce <double>(cube->damping * 50.0, position, closestPoint, velocity, glm::dvec3(0.0));
 
     // F = ma -> a = F / m 
+    return (springForce + dampingForce) / double(cube->mass);
+}
+
+template <typename Real>
+void processCollisionResponse(Cube* const cube, ParticleStore <Real>& particles, const int currentPoint, const glm::dvec3& closestPoint) {
     // update force on current mass point that collided
-    massPoint->addAcceleration((springForce + dampingForce) / double(cube->mass));
+    const glm::dvec3 position = particles.getPosition(currentPoint);
+    particles.addAcceleration(currentPoint, contactAcceleration(cube, position, particles.getVelocity(currentPoint), closestPoint));
+}
+
+template void processCollisionResponse <float>(Cube* const cube, ParticleStore <float>& particles, const int currentPoint, const glm::dvec3& closestPoint);
+template void processCollisionResponse <double>(Cube* const cube, ParticleStore <double>& particles, const int currentPoint, const glm::dvec3& closestPoint);
+
+/**
+ * wall contact acceleration of a single point, 0 while it is inside the bounding box
+ * @param Cube* const cube - cube with stiffness, damping and mass
+ * @param const glm::dvec3& position, const glm::dvec3& velocity - state of the point
+ * @return glm::dvec3 - contact acceleration
+ */
+glm::dvec3 computeContactAcceleration(Cube* const cube, const glm::dvec3& position, const glm::dvec3& velocity) {
+    glm::dvec3 closestPoint;
+    if (!checkCollision(position, boundingBox, closestPoint)) {
+        return glm::dvec3(0.0);
+    }
+    return contactAcceleration(cube, position, velocity, closestPoint);
 }
 
 // PHYSICS
 
 /**
- * computes spring force and acceleration per point 
- * @param const double* const  stiffness - constant pointer to constant double stiffness 
- * @param const double* const  damping - vertex A of triangle
- * @param const double* const  mass - vertex B of triangle
- * @param MassPoint* const currentPoint - constant pointer to current MassPoint
+ * computes spring force and acceleration for every spring in the cube's spring table
+ * @param const Real stiffness - stiffness of the springs
+ * @param const Real damping - damping of the springs
+ * @param const Real mass - mass of every point
+ * @param Cube* const cube - constant pointer to the cube that owns the spring table
+ * @param ParticleStore <Real>& particles - particle state to read and accumulate into
+ */
+template <typename Real>
+void computeSpringAcceleration(const Real stiffness, const Real damping, const Real mass, Cube* const cube, ParticleStore <Real>& particles) {
+    const SpringTable& springs = cube->springs;
+
+    // stiffness per spring type
+    Real kh[SPRING_TYPE_COUNT];
+    for (int t = 0; t < SPRING_TYPE_COUNT; t++) {
+        kh[t] = stiffness * Real(cube->springTypeStiffness[t]);
+    }
+
+    // fused spring + damping kernel for the vector width the cpu supports
+    const springKernel <Real> kernel = getSpringKernel <Real>(simdLevelEnum(cube->simdLevel));
+    const Real invMass = Real(1) / mass;
+
+    // groups (bricks) of one phase never share a point, so they are accumulated in parallel
+    // a group runs its batches in order, springs inside a batch never share a point so they fill vector lanes
+    // every point receives its forces in the same order, which keeps the result the same for any thread count
+    #pragma omp parallel
+    {
+        for (int phase = 0; phase < springs.phaseCount(); phase++) {
+            const int firstGroup = springs.phaseOffsets[phase];
+            const int lastGroup = springs.phaseOffsets[phase + 1];
+
+            // implicit barrier at the end, next phase waits for this one
+            #pragma omp for schedule(dynamic)
+            for (int group = firstGroup; group < lastGroup; group++) {
+                for (int batch = springs.groupOffsets[group]; batch < springs.groupOffsets[group + 1]; batch++) {
+                    kernel(springs, springs.batchOffsets[batch], springs.batchOffsets[batch + 1], kh, damping, invMass, particles);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * gathers spring force and acceleration per point from the fixed lattice stencil,
+ * neighbors are found with index arithmetic and every point only writes its own acceleration
+ * (each spring is evaluated from both of its points)
+ * @param const Real stiffness - stiffness of the springs
+ * @param const Real damping - damping of the springs
+ * @param const Real mass - mass of every point
+ * @param Cube* const cube - constant pointer to the cube that owns the stencil
+ * @param ParticleStore <Real>& particles - particle state to read and accumulate into
  */
-void computeSpringAcceleration(const double& stiffness, const double& damping, const double& mass, MassPoint* const currentPoint) {
-    // gets all connected masspoints (depends on the spring types enabled)
-    for (int c = 0; c < currentPoint->getConnectionCount(); c++) {
-        MassPoint* pointB = currentPoint->getConnection(c);
-
-        glm::dvec3 s = calculateSpringForce(stiffness, currentPoint, pointB);
-        glm::dvec3 d = calculateDampingForce(damping, currentPoint, pointB);
-        glm::dvec3 force = s + d;
-        
-        // F = ma -> a = F / m 
-        // update force on current mass point
-        currentPoint->addAcceleration(force / mass);
-        // update opposite forces on B 
-        pointB->addAcceleration(-force / mass);
+template <typename Real>
+void computeLatticeSpringAcceleration(const Real stiffness, const Real damping, const Real mass, Cube* const cube, ParticleStore <Real>& particles) {
+    typedef glm::vec<3, Real> vec3;
+    const LatticeStencil& stencil = cube->stencil;
+    const int res = cube->resolution;
+    const bool reordered = cube->latticeToParticle != nullptr;
+
+    // stiffness per spring type
+    Real kh[SPRING_TYPE_COUNT];
+    for (int t = 0; t < SPRING_TYPE_COUNT; t++) {
+        kh[t] = stiffness * Real(cube->springTypeStiffness[t]);
+    }
+
+    #pragma omp parallel for
+    for (int j = 0; j < res; j++) {
+        for (int k = 0; k < res; k++) {
+            for (int i = 0; i < res; i++) {
+                const int pointA = cube->pointIndex(i, j, k);
+                const vec3 posA = particles.getPosition(pointA);
+                const vec3 velA = particles.getVelocity(pointA);
+
+                vec3 force = vec3(0);
+                for (int n = 0; n < stencil.size(); n++) {
+                    // neighbor outside the lattice (surface points)
+                    const int ni = i + stencil.di[n];
+                    const int nj = j + stencil.dj[n];
+                    const int nk = k + stencil.dk[n];
+                    if (ni < 0 || nj < 0 || nk < 0 || ni >= res || nj >= res || nk >= res) {
+                        continue;
+                    }
+
+                    // the offset only holds while particles are in lattice order
+                    const int pointB = reordered ? cube->pointIndex(ni, nj, nk) : pointA + stencil.indexOffset[n];
+                    const vec3 posB = particles.getPosition(pointB);
+
+                    force += calculateSpringForce <Real>(kh[stencil.type[n]], posA, posB, Real(stencil.restLength[n]));
+                    force += calculateDampingForce <Real>(damping, posA, posB, velA, particles.getVelocity(pointB));
+                }
+
+                // F = ma -> a = F / m 
+                particles.addAcceleration(pointA, force / mass);
+            }
+        }
     }
 }
 
 /**
  * computes accumulated acceleration for all masspoints in cube
  * @param Cube* cube
+ * @param ParticleStore <Real>& particles - state to evaluate, the cube's own particles or a stage of an integrator
  */
-void computeAcceleration(Cube* cube, double timeStep) {
+template <typename Real>
+void computeAcceleration(Cube* cube, ParticleStore <Real>& particles, double timeStep) {
     // reset accumulated acceleration to 0
-    cube->resetAcceleration();
+    particles.resetAcceleration();
 
-    // goes through all masspoints
-    #pragma omp parallel for shared(boundingBox)
-    for (int i = 0; i < cube->discretePoints.size(); i++) {
-        MassPoint* currentPoint = cube->discretePoints[i];
+    // calculate spring acceleration from every spring
+    if (cube->latticeGather) {
+        computeLatticeSpringAcceleration <Real>(cube->stiffness, cube->damping, cube->mass, cube, particles);
+    }
+    else {
+        computeSpringAcceleration <Real>(cube->stiffness, cube->damping, cube->mass, cube, particles);
+    }
 
-        // calculate spring acceleration for each mass points
-        computeSpringAcceleration(cube->stiffness, cube->damping, cube->mass, currentPoint);
+    // wall contacts and external forces of all masspoints in one sweep
+    computeBoxContactAcceleration <Real>(cube, particles);
+
+    // obstacles
+    if (colliders != nullptr) {
+        colliders->addContactAcceleration <Real>(cube, particles);
+    }
 
-        // check if each point collides with bounding box
-        glm::dvec3 closestPoint;
-        if (checkCollision(currentPoint, boundingBox, closestPoint)) {
-            // if collided, process collision response 
-            processCollisionResponse(cube, currentPoint, closestPoint);
+    // the cube folding into itself
+    if (cube->selfCollision) {
+        cube->getSelfCollider<Real>().addContactAcceleration(cube, particles);
+    }
+
+    // other cubes of the world
+    if (cube->bodyContacts > 0) {
+        const glm::dvec3* bodyContact = cube->bodyContact.data();
+        #pragma omp parallel for
+        for (int i = 0; i < particles.size(); i++) {
+            particles.addAcceleration(i, bodyContact[i]);
         }
+    }
+}
+
+template void computeAcceleration <float>(Cube* cube, ParticleStore <float>& particles, double timeStep);
+template void computeAcceleration <double>(Cube* cube, ParticleStore <double>& particles, double timeStep);
 
-        // external forces
-        // TODO  division is expensive? 
-        glm::dvec3 externalAcc = (*currentPoint->getExternalForce()) / double(cube->mass);
-        currentPoint->addAcceleration(externalAcc);
+// evaluates the cube's own particles in the cube's precision
+void computeAcceleration(Cube* cube, double timeStep) {
+    if (cube->getPrecision() == PRECISION_FLOAT) {
+        computeAcceleration <float>(cube, cube->particlesFloat, timeStep);
+    }
+    else {
+        computeAcceleration <double>(cube, cube->particles, timeStep);
     }
 }
 
 /**
  * computes Hooks law in 3D (spring force)
- * @param const double* const kh - hook's constant = stiffness (should be negative)
- * @param MassPoint* pointA - current mass point
- * @param MassPoint* pointB - neighboring mass point
- * @return glm::dvec3 - spring force
+ * @param const Real kh - hook's constant = stiffness (should be negative)
+ * @param const glm::vec<3, Real>& pointA - position of current mass point
+ * @param const glm::vec<3, Real>& pointB - position of neighboring mass point
+ * @param const Real restLength - cached length of the spring at rest
+ * @return glm::vec<3, Real> - spring force
  */
-glm::dvec3 calculateSpringForce(const double& const kh, MassPoint* pointA, MassPoint* pointB) {
-    // F = kh * (|L| - R) * (L / |L|)
-    // vector from start to end = end - start
-    glm::dvec3 L = *(pointA->getPosition()) - *(pointB->getPosition()); // vector from current neighbor (pointB) to point (pointA)
-    double currentLength = glm::length(L);
-    double restLength = glm::length(*(pointA->getInitialPosition()) - *(pointB->getInitialPosition()));
-
-    return calculateSpringForce(kh, *(pointA->getPosition()), *(pointB->getPosition()), restLength);
-}
-glm::dvec3 calculateSpringForce(const double& kh, const glm::dvec3& pointA, const glm::dvec3& pointB, const double restLength) {
+template <typename Real>
+glm::vec<3, Real> calculateSpringForce(const Real kh, const glm::vec<3, Real>& pointA, const glm::vec<3, Real>& pointB, const Real restLength) {
     // F = kh * (|L| - R) * (L / |L|)
     // vector from start to end = end - start
 
-    glm::dvec3 L = pointA - pointB; // vector from current neighbor (pointB) to point (pointA)
-    double currentLength = glm::length(L);
-    //double restLength = glm::length(*(pointA->getInitialPosition()) - *(pointB->getInitialPosition()));
+    glm::vec<3, Real> L = pointA - pointB; // vector from current neighbor (pointB) to point (pointA)
+    Real currentLength = glm::length(L);
 
     // stiffness (kh) is a negative force
-    return (-1.0) * kh * (currentLength - restLength) * (L / currentLength);
+    return Real(-1) * kh * (currentLength - restLength) * (L / currentLength);
 }
 
+template glm::vec<3, float> calculateSpringForce <float>(const float, const glm::vec<3, float>&, const glm::vec<3, float>&, const float);
+template glm::vec<3, double> calculateSpringForce <double>(const double, const glm::vec<3, double>&, const glm::vec<3, double>&, const double);
+
 /**
  * computes damping force in 3D 
- * @param const double* const kd - damping constant (should be negative)
- * @param MassPoint* pointA - current mass point
- * @param MassPoint* pointB - neighboring mass point
- * @return glm::dvec3 - damping force
+ * @param const Real kd - damping constant (should be negative)
+ * @param const glm::vec<3, Real>& pointA - position of current mass point
+ * @param const glm::vec<3, Real>& pointB - position of neighboring mass point
+ * @param const glm::vec<3, Real>& velA - velocity of current mass point
+ * @param const glm::vec<3, Real>& velB - velocity of neighboring mass point
+ * @return glm::vec<3, Real> - damping force
  */
-glm::dvec3 calculateDampingForce(const double& const kd, MassPoint* const pointA, MassPoint* const pointB) {
-    return calculateDampingForce(kd, *(pointA->getPosition()), *(pointB->getPosition()), *(pointA->getVelocity()), *(pointB->getVelocity()));
-}
-glm::dvec3 calculateDampingForce(const double& kd, const glm::dvec3& pointA, const glm::dvec3& pointB, const glm::dvec3& velA, const glm::dvec3& velB) {
+template <typename Real>
+glm::vec<3, Real> calculateDampingForce(const Real kd, const glm::vec<3, Real>& pointA, const glm::vec<3, Real>& pointB, const glm::vec<3, Real>& velA, const glm::vec<3, Real>& velB) {
     // F = kd * ((Va - Vb) dot L ) / |L| * (L / |L|)
-    glm::dvec3 L = pointA - pointB; // vector from current neighbor (pointB) to point (pointA)
-    double lengthL = glm::length(L); // current distance between pointA and pointB
-    glm::dvec3 velocityDiff = velA - velB;
+    glm::vec<3, Real> L = pointA - pointB; // vector from current neighbor (pointB) to point (pointA)
+    Real lengthL = glm::length(L); // current distance between pointA and pointB
+    glm::vec<3, Real> velocityDiff = velA - velB;
 
     // damping value (kh) is a negative force
-    return (-1.0) * kd * (glm::dot(velocityDiff, L) / lengthL) * (L / lengthL);
+    return Real(-1) * kd * (glm::dot(velocityDiff, L) / lengthL) * (L / lengthL);
 }
 
+template glm::vec<3, float> calculateDampingForce <float>(const float, const glm::vec<3, float>&, const glm::vec<3, float>&, const glm::vec<3, float>&, const glm::vec<3, float>&);
+template glm::vec<3, double> calculateDampingForce <double>(const double, const glm::vec<3, double>&, const glm::vec<3, double>&, const glm::vec<3, double>&, const glm::vec<3, double>&);
+
+
+/**
+ * spring damping as a velocity pass along every spring (colored, springs of a color run in parallel),
+ * used by the solvers that move positions directly and derive the velocities (XPBD, projective dynamics)
+ * removes the fraction damping * dt * (wa + wb) of the relative velocity along the spring,
+ * the same as the damping force to first order, but never reverses the relative velocity
+ * @param Cube* cube - cube with the springs and damping
+ * @param ParticleStore <Real>& p - particles to damp
+ * @param Real timeStep - dt
+ */
+template <typename Real>
+void applySpringDamping(Cube* cube, ParticleStore <Real>& p, Real timeStep) {
+    typedef glm::vec<3, Real> vec3;
+    const SpringTable& springs = cube->springs;
+    const Real inverseMass = Real(1) / Real(cube->mass);
+    const Real damping = Real(cube->damping);
+
+    if (damping == Real(0)) {
+        return;
+    }
+
+    springs.forEachColored([&](int s) {
+        const int pointA = springs.pointA[s];
+        const int pointB = springs.pointB[s];
+        const Real wa = p.isFixed(pointA) ? Real(0) : inverseMass;
+        const Real wb = p.isFixed(pointB) ? Real(0) : inverseMass;
+        const vec3 L = p.getPosition(pointA) - p.getPosition(pointB);
+        const Real length = glm::length(L);
+        if (wa + wb == Real(0) || length == Real(0)) {
+            return;
+        }
+
+        const vec3 n = L / length;
+        const Real relative = glm::dot(n, p.getVelocity(pointA) - p.getVelocity(pointB));
+        const Real fraction = std::min(Real(1), damping * timeStep * (wa + wb));
+        const vec3 impulse = (fraction * relative / (wa + wb)) * n;
+
+        p.setVelocity(pointA, p.getVelocity(pointA) - wa * impulse);
+        p.setVelocity(pointB, p.getVelocity(pointB) + wb * impulse);
+    });
+}
+
+template void applySpringDamping <float>(Cube* cube, ParticleStore <float>& p, float timeStep);
+template void applySpringDamping <double>(Cube* cube, ParticleStore <double>& p, double timeStep);
 
 // INTEGRATORS - numerical solution to analytical problems
 
 /**
- * performs one step Euler integration (may explode if time step is too big), 
- * approximating the acceleration
+ * performs one step semi-implicit (symplectic) Euler integration (may explode if time step is too big),
+ * approximating the acceleration, one force evaluation per step
  * velocity = dx/dt (change in position over change in time)
  * acceleration = dv/dt (change in velocity over change in time)
+ * the position moves with the updated velocity, which keeps the energy of the springs bounded
+ * where plain (explicit) Euler gains energy every step
  * @param Cube* const cube - constant pointer to a cube
+ * @param ParticleStore <Real>& p - the cube's particles of precision Real
  */
-void integrateEuler(Cube* const cube, double timeStep) {
-    
+template <typename Real>
+void integrateEuler(Cube* const cube, ParticleStore <Real>& p, double timeStep) {
+    const Real dt = Real(timeStep);
+
     // compute accumulated acceleration of mass points in cube
-    computeAcceleration(cube, timeStep);
+    computeAcceleration <Real>(cube, p, timeStep);
 
     // integrate 
     #pragma omp parallel for
-    for (int i = 0; i < cube->discretePoints.size(); i++) {
-        MassPoint* currentPoint = cube->discretePoints[i];
-        if (currentPoint->isFixed() == true) {
+    for (int i = 0; i < p.size(); i++) {
+        if (p.isFixed(i) == true) {
             // stays the same
             continue;
         }
 
         // one step euler
         // Velocity
-        glm::dvec3 vel = *currentPoint->getVelocity() + (*currentPoint->getAcceleration() * timeStep);
-        currentPoint->setVelocity(vel);
+        p.vx[i] += p.ax[i] * dt;
+        p.vy[i] += p.ay[i] * dt;
+        p.vz[i] += p.az[i] * dt;
 
         // Position
-        glm::dvec3 pos = *currentPoint->getPosition() + (*currentPoint->getVelocity() * timeStep);
-        currentPoint->setPosition(pos);
+        p.px[i] += p.vx[i] * dt;
+        p.py[i] += p.vy[i] * dt;
+        p.pz[i] += p.vz[i] * dt;
     }
 }
 
+template void integrateEuler <float>(Cube* const cube, ParticleStore <float>& p, double timeStep);
+template void integrateEuler <double>(Cube* const cube, ParticleStore <double>& p, double timeStep);
+
 /**
- * performs Runge-Kutta 4th order integration (more stable but requires smaller time step than euler),
- * approximating the change in position and velocity using doubles
+ * keeps the positions at the start of a step for the swept collision, nothing without it
  * @param Cube* const cube - constant pointer to a cube
  */
+static void beginSweep(Cube* const cube) {
+    if (!cube->sweptCollision) {
+        return;
+    }
+    if (cube->getPrecision() == PRECISION_FLOAT) {
+        cube->sweptColliderFloat.begin(cube->particlesFloat);
+    }
+    else {
+        cube->sweptCollider.begin(cube->particles);
+    }
+}
 
-void integrateRK4(Cube* cube, double timeStep) {
-    // needs 4 integration for both point and velocity 
-    // approximate differential equations
+/**
+ * sweeps the points from their start to their end of the step against the walls and the obstacles,
+ * a point that bounced off one leaves the acceleration of the step end stale
+ * @param Cube* const cube - constant pointer to a cube
+ * @param double timeStep - dt of the step
+ */
+static void endSweep(Cube* const cube, double timeStep) {
+    if (!cube->sweptCollision) {
+        return;
+    }
+    // the impact reflects the velocity into the surface
+    syncVelocity(cube);
+    int impacts;
+    if (cube->getPrecision() == PRECISION_FLOAT) {
+        impacts = cube->sweptColliderFloat.resolve(cube->particlesFloat, timeStep, double(cube->sweptRestitution));
+    }
+    else {
+        impacts = cube->sweptCollider.resolve(cube->particles, timeStep, double(cube->sweptRestitution));
+    }
+    if (impacts > 0) {
+        cube->accelerationCurrent = false;
+    }
+    cube->sweptCollisionStats.impacts = impacts;
+}
 
-    // make 4 arrays of glm::dvec3 for differentiated position and velocity
-    std::vector <glm::dvec3> F1p{}; // first step for position
-    std::vector <glm::dvec3> F2p{}; // second step for position
-    std::vector <glm::dvec3> F3p{}; // third step for position
-    std::vector <glm::dvec3> F4p{}; // fourth step for position
+void integrateEuler(Cube* const cube, double timeStep) {
+    // accelerations are left at the start of the step
+    cube->accelerationCurrent = false;
+    syncVelocity(cube);
+    beginSweep(cube);
+    if (cube->getPrecision() == PRECISION_FLOAT) {
+        integrateEuler <float>(cube, cube->particlesFloat, timeStep);
+    }
+    else {
+        integrateEuler <double>(cube, cube->particles, timeStep);
+    }
+    endSweep(cube, timeStep);
+}
 
-    std::vector <glm::dvec3> F1v{}; // first step for velocity
-    std::vector <glm::dvec3> F2v{}; // second step for velocity
-    std::vector <glm::dvec3> F3v{}; // third step for velocity
-    std::vector <glm::dvec3> F4v{}; // fourth step for velocity
+/**
+ * performs one velocity Verlet step (kick, drift, kick), second order and symplectic
+ * the acceleration at the end of a step is the one the next step starts with,
+ * so only one force evaluation per step is needed (two on the first step)
+ * damping forces are evaluated with the half step velocity
+ * @param Cube* const cube - constant pointer to a cube
+ * @param ParticleStore <Real>& p - the cube's particles of precision Real
+ */
+template <typename Real>
+void integrateVelocityVerlet(Cube* const cube, ParticleStore <Real>& p, double timeStep) {
+    const Real dt = Real(timeStep);
+    const Real halfStep = Real(0.5) * dt;
 
-    Cube buffer = *cube; // make a copy of cube
+    if (!cube->accelerationCurrent) {
+        computeAcceleration <Real>(cube, p, timeStep);
+    }
 
-    // compute accumulated acceleration for all mass points in cube
-    computeAcceleration(cube, timeStep);
+    // v(t + dt/2) = v(t) + a(t) * dt/2, x(t + dt) = x(t) + v(t + dt/2) * dt
+    #pragma omp parallel for
+    for (int i = 0; i < p.size(); i++) {
+        if (p.isFixed(i) == true) {
+            // stays the same
+            continue;
+        }
 
-    // integrate
-    for (int i = 0; i < cube->discretePoints.size(); i++) {
-        MassPoint* currentPoint = cube->discretePoints[i];
-        MassPoint* bufferPoint = buffer.discretePoints[i];
+        p.vx[i] += p.ax[i] * halfStep;
+        p.vy[i] += p.ay[i] * halfStep;
+        p.vz[i] += p.az[i] * halfStep;
 
-        // dx/dt = F(t, x)
-        // 1st step: k1 =  F(t0, x0)
-        glm::dvec3 dVel = *currentPoint->getVelocity() * timeStep;
-        // Velocity
-        glm::dvec3 dAcc = *currentPoint->getAcceleration() * timeStep;
-
-        F1p.push_back(dVel);
-        F1v.push_back(dAcc);
-        
-        // store for second step: 
-        glm::dvec3 m_pos = *currentPoint->getPosition() + (dVel * 0.5);
-        glm::dvec3 m_vel = *currentPoint->getVelocity() + (dAcc * 0.5);
-        
-        if (currentPoint->isFixed() == true) {
-            // no change
-            bufferPoint->setPosition(*currentPoint->getPosition());
-            bufferPoint->setVelocity(*currentPoint->getVelocity());
-        }
-        else {
-            bufferPoint->setPosition(m_pos);
-            bufferPoint->setVelocity(m_vel);
-        }
+        p.px[i] += p.vx[i] * dt;
+        p.py[i] += p.vy[i] * dt;
+        p.pz[i] += p.vz[i] * dt;
     }
 
-    computeAcceleration(&buffer, timeStep);
-
-    for (int i = 0; i < cube->discretePoints.size(); i++) {
-        MassPoint* currentPoint = cube->discretePoints[i];
-        MassPoint* bufferPoint = buffer.discretePoints[i];
+    // a(t + dt), kept for the next step
+    computeAcceleration <Real>(cube, p, timeStep);
+    cube->accelerationCurrent = true;
 
-        // 2nd step: k2 = F(t + dt/2, x + h * k1/2) 
-        // Position
-        glm::dvec3 dVel = *bufferPoint->getVelocity()* timeStep;
-        F2p.push_back(dVel);
-        
-        // Velocity
-        glm::dvec3 dAcc = *bufferPoint->getAcceleration() * timeStep;
-        F2v.push_back(dAcc);
-
-        // store for 3rd step
-        glm::dvec3 m_pos = *currentPoint->getPosition() + (dVel * 0.5);
-        glm::dvec3 m_vel = *currentPoint->getVelocity() + (dAcc * 0.5);
-       
-        if (currentPoint->isFixed() == true) {
-            // no change
-            bufferPoint->setPosition(*currentPoint->getPosition());
-            bufferPoint->setVelocity(*currentPoint->getVelocity());
-        }
-        else {
-            bufferPoint->setPosition(m_pos);
-            bufferPoint->setVelocity(m_vel);
+    // v(t + dt) = v(t + dt/2) + a(t + dt) * dt/2
+    #pragma omp parallel for
+    for (int i = 0; i < p.size(); i++) {
+        if (p.isFixed(i) == true) {
+            continue;
         }
-    }
 
-    computeAcceleration(&buffer, timeStep);
-
-    for (int i = 0; i < cube->discretePoints.size(); i++) {
-        MassPoint* currentPoint = cube->discretePoints[i];
-        MassPoint* bufferPoint = buffer.discretePoints[i];
+        p.vx[i] += p.ax[i] * halfStep;
+        p.vy[i] += p.ay[i] * halfStep;
+        p.vz[i] += p.az[i] * halfStep;
+    }
+}
 
-        // 3rd step: k3 = F(t + dt/2, x + h * k2/2) 
-        // Position
-        glm::dvec3 dVel = *bufferPoint->getVelocity() * timeStep;
-        F3p.push_back(dVel);
+template void integrateVelocityVerlet <float>(Cube* const cube, ParticleStore <float>& p, double timeStep);
+template void integrateVelocityVerlet <double>(Cube* const cube, ParticleStore <double>& p, double timeStep);
 
-        // Velocity
-        glm::dvec3 dAcc = *bufferPoint->getAcceleration() * timeStep;
-        F3v.push_back(dAcc);
+void integrateVelocityVerlet(Cube* const cube, double timeStep) {
+    syncVelocity(cube);
+    beginSweep(cube);
+    if (cube->getPrecision() == PRECISION_FLOAT) {
+        integrateVelocityVerlet <float>(cube, cube->particlesFloat, timeStep);
+    }
+    else {
+        integrateVelocityVerlet <double>(cube, cube->particles, timeStep);
+    }
+    endSweep(cube, timeStep);
+}
 
-        // store for 4th step
-        glm::dvec3 m_pos = *currentPoint->getPosition() + dVel;
-        glm::dvec3 m_vel = *currentPoint->getVelocity() + dAcc;
+/**
+ * performs Runge-Kutta 4th order integration (more stable but requires smaller time step than euler),
+ * approximating the change in position and velocity in the cube's precision
+ * stage buffers are owned by the cube's RK4Integrator so no memory is allocated per step
+ * @param Cube* const cube - constant pointer to a cube
+ */
+void integrateRK4(Cube* cube, double timeStep) {
+    cube->accelerationCurrent = false;
+    syncVelocity(cube);
+    beginSweep(cube);
+    if (cube->getPrecision() == PRECISION_FLOAT) {
+        cube->rk4Float.step(cube, timeStep);
+    }
+    else {
+        cube->rk4.step(cube, timeStep);
+    }
+    endSweep(cube, timeStep);
+}
 
-        if (currentPoint->isFixed() == true) {
-            // no change
-            bufferPoint->setPosition(*currentPoint->getPosition());
-            bufferPoint->setVelocity(*currentPoint->getVelocity());
-        }
-        else {
-            bufferPoint->setPosition(m_pos);
-            bufferPoint->setVelocity(m_vel);
-        }
+/**
+ * performs one backward (implicit) Euler step, stable for stiff springs at large time steps
+ * (1/60 s at the top of the stiffness slider), the linear system is solved with conjugate gradient
+ * owned by the cube's ImplicitEulerIntegrator, iterations and residual end up in cube->solverStats
+ * @param Cube* const cube - constant pointer to a cube
+ */
+void integrateImplicitEuler(Cube* cube, double timeStep) {
+    cube->accelerationCurrent = false;
+    syncVelocity(cube);
+    beginSweep(cube);
+    if (cube->getPrecision() == PRECISION_FLOAT) {
+        cube->implicitEulerFloat.step(cube, timeStep);
+    }
+    else {
+        cube->implicitEuler.step(cube, timeStep);
     }
+    endSweep(cube, timeStep);
+}
 
-    computeAcceleration(&buffer, timeStep);
+/**
+ * advances the cube by one step of the simulation clock with adaptive Runge-Kutta (Bogacki-Shampine 3(2)) steps,
+ * the step size follows the estimated error within the cube's bounds, large while the jello rests
+ * and small while it is shaken, the accepted steps are recorded in cube->stepHistory
+ * @param Cube* const cube - constant pointer to a cube
+ * @param double frameTime - fixed step of the clock (s)
+ */
+void integrateAdaptive(Cube* cube, double frameTime) {
+    cube->accelerationCurrent = false;
+    syncVelocity(cube);
+    beginSweep(cube);
+    if (cube->getPrecision() == PRECISION_FLOAT) {
+        cube->adaptiveFloat.advance(cube, frameTime);
+    }
+    else {
+        cube->adaptive.advance(cube, frameTime);
+    }
+    endSweep(cube, frameTime);
+}
 
-    for (int i = 0; i < cube->discretePoints.size(); i++) {
-        MassPoint* currentPoint = cube->discretePoints[i];
-        MassPoint* bufferPoint = buffer.discretePoints[i];
+/**
+ * performs one XPBD step, springs are compliant distance constraints and the bounding box walls
+ * hard contacts, stable for any stiffness and time step, quality grows with substeps and iterations
+ * @param Cube* const cube - constant pointer to a cube
+ */
+void integrateXPBD(Cube* cube, double timeStep) {
+    cube->accelerationCurrent = false;
+    syncVelocity(cube);
+    beginSweep(cube);
+    if (cube->getPrecision() == PRECISION_FLOAT) {
+        cube->xpbdFloat.step(cube, timeStep);
+    }
+    else {
+        cube->xpbd.step(cube, timeStep);
+    }
+    endSweep(cube, timeStep);
+}
 
-        // 4th step: k4 = F(t + dt, x + h * k3) 
-        // Position
-        glm::dvec3 dVel = *bufferPoint->getVelocity() * timeStep;
-        F4p.push_back(dVel);
+/**
+ * performs one projective dynamics step, implicit in the springs with a prefactored system matrix,
+ * the factor is reused until the topology, stiffness, mass or time step changes
+ * @param Cube* const cube - constant pointer to a cube
+ */
+void integrateProjectiveDynamics(Cube* cube, double timeStep) {
+    cube->accelerationCurrent = false;
+    syncVelocity(cube);
+    beginSweep(cube);
+    if (cube->getPrecision() == PRECISION_FLOAT) {
+        cube->projectiveDynamicsFloat.step(cube, timeStep);
+    }
+    else {
+        cube->projectiveDynamics.step(cube, timeStep);
+    }
+    endSweep(cube, timeStep);
+}
 
-        // Velocity
-        glm::dvec3 dAcc = *bufferPoint->getAcceleration() * timeStep;
-        F4v.push_back(dAcc);
+/**
+ * performs one position Verlet (Stormer) step, the state is the current and previous position and
+ * velocities are only derived while damping needs them, same stability limit as symplectic Euler
+ * @param Cube* const cube - constant pointer to a cube
+ */
+void integratePositionVerlet(Cube* cube, double timeStep) {
+    cube->accelerationCurrent = false;
+    beginSweep(cube);
+    if (cube->getPrecision() == PRECISION_FLOAT) {
+        cube->positionVerletFloat.step(cube, timeStep);
+    }
+    else {
+        cube->positionVerlet.step(cube, timeStep);
+    }
+    endSweep(cube, timeStep);
+}
 
-        if (currentPoint->isFixed() == true) {
-            // no change
-            continue;
-        }
+/**
+ * performs one multirate step, points in (or about to hit) wall contact and points on stiff springs
+ * subcycle their fast forces at a fraction of the step, the rest of the cube takes the whole step at once
+ * @param Cube* const cube - constant pointer to a cube
+ */
+void integrateMultirate(Cube* cube, double timeStep) {
+    cube->accelerationCurrent = false;
+    syncVelocity(cube);
+    beginSweep(cube);
+    if (cube->getPrecision() == PRECISION_FLOAT) {
+        cube->multirateFloat.step(cube, timeStep);
+    }
+    else {
+        cube->multirate.step(cube, timeStep);
+    }
+    endSweep(cube, timeStep);
+}
 
-        // dx = dt * (k1 + 2 * k2 + 2* k3 + k4)/6
-        // x = x + dx
-        glm::dvec3 p = *currentPoint->getPosition() + ((F1p[i] + (F2p[i] * 2.0) + (F3p[i] * 2.0) + F4p[i]) / 6.0);
-        glm::dvec3 v = *currentPoint->getVelocity() + ((F1v[i] + (F2v[i] * 2.0) + (F3v[i] * 2.0) + F4v[i]) / 6.0);
-        currentPoint->setVelocity(v);
-        currentPoint->setPosition(p);
+/**
+ * brings the velocities in the particle store up to date after position Verlet steps,
+ * called by every other integrator before it reads them
+ * @param Cube* const cube - constant pointer to a cube
+ */
+void syncVelocity(Cube* cube) {
+    if (cube->velocityCurrent) {
+        return;
+    }
+    if (cube->getPrecision() == PRECISION_FLOAT) {
+        cube->positionVerletFloat.deriveVelocity(cube);
+    }
+    else {
+        cube->positionVerlet.deriveVelocity(cube);
     }
+    cube->velocityCurrent = true;
+}
 
-}
\ No newline at end of file
+/**
+ * fewest substeps of an explicit integrator that keep a step of timeStep under its stability limit,
+ * the estimate follows stiffness, damping and mass as they change and ends up in cube->stabilityLimit
+ * @param Cube* const cube - constant pointer to a cube
+ * @param explicitMethodEnum method - integrator the step is split for
+ * @param double timeStep - dt of the whole step
+ * @return int - substeps, timeStep / substeps each
+ */
+int stableSubsteps(Cube* cube, explicitMethodEnum method, double timeStep) {
+    StabilityLimit limit = cube->stabilityEstimator.estimate(cube);
+    limit.stableStep = double(cube->stabilitySafety) * StabilityEstimator::stableStep(limit.omega, limit.damping, method);
+    const double substeps = std::ceil(timeStep / limit.stableStep);
+    limit.substeps = substeps < 1.0 ? 1 : int(std::min(substeps, double(std::max(1, cube->maxStableSubsteps))));
+    cube->stabilityLimit = limit;
+    return limit.substeps;
+}
@@ -12,32 +12,64 @@
 #include "Plane.h"
 #include "Cube.h" 
 #include "BoundingBox.h"
+#include "Collider.h"
 
 // takes care of the interactions between the objects in scene
-// all mass points (physics) related should use double precision
+// mass points (physics) run in the cube's precision (float or double), templates are
+// instantiated for both in Physics.cpp and the plain functions pick the one of the cube
 
 // global variable
 extern BoundingBox* boundingBox;
+// obstacles inside the bounding box, may be null
+extern ColliderSet* colliders;
 
 // jelly simulation
-glm::dvec3 calculateSpringForce(const double& kh, const glm::dvec3& pointA, const glm::dvec3& pointB, const double restLength);
-glm::dvec3 calculateSpringForce(const double& const kh, MassPoint* const pointA, MassPoint* const pointB);
+template <typename Real>
+glm::vec<3, Real> calculateSpringForce(const Real kh, const glm::vec<3, Real>& pointA, const glm::vec<3, Real>& pointB, const Real restLength);
 
-glm::dvec3 calculateDampingForce(const double& kd, const glm::dvec3& pointA, const glm::dvec3& pointB, const glm::dvec3& velA, const glm::dvec3& velB);
-glm::dvec3 calculateDampingForce(const double& const kd, MassPoint* const pointA, MassPoint* const pointB);
+template <typename Real>
+glm::vec<3, Real> calculateDampingForce(const Real kd, const glm::vec<3, Real>& pointA, const glm::vec<3, Real>& pointB, const glm::vec<3, Real>& velA, const glm::vec<3, Real>& velB);
 
 // internal
-void computeSpringAcceleration(const double& stiffness, const double& damping, const double& mass, MassPoint* const currentPoint);
+template <typename Real>
+void computeSpringAcceleration(const Real stiffness, const Real damping, const Real mass, Cube* const cube, ParticleStore <Real>& particles);
+template <typename Real>
+void computeLatticeSpringAcceleration(const Real stiffness, const Real damping, const Real mass, Cube* const cube, ParticleStore <Real>& particles);
+template <typename Real>
+void computeAcceleration(Cube* cube, ParticleStore <Real>& particles, double timeStep);
 void computeAcceleration(Cube* cube, double timeStep);
 
+// velocity pass of the spring damping for the position based solvers
+template <typename Real>
+void applySpringDamping(Cube* cube, ParticleStore <Real>& particles, Real timeStep);
+
 // integrators
+template <typename Real>
+void integrateEuler(Cube* cube, ParticleStore <Real>& particles, double timeStep);
 void integrateEuler(Cube* cube, double timeStep);
+template <typename Real>
+void integrateVelocityVerlet(Cube* cube, ParticleStore <Real>& particles, double timeStep);
+void integrateVelocityVerlet(Cube* cube, double timeStep);
 void integrateRK4(Cube* cube, double timeStep);
+void integrateImplicitEuler(Cube* cube, double timeStep);
+void integrateAdaptive(Cube* cube, double frameTime);
+void integrateXPBD(Cube* cube, double timeStep);
+void integrateProjectiveDynamics(Cube* cube, double timeStep);
+void integratePositionVerlet(Cube* cube, double timeStep);
+void integrateMultirate(Cube* cube, double timeStep);
+void syncVelocity(Cube* cube);
+int stableSubsteps(Cube* cube, explicitMethodEnum method, double timeStep);
 
 // collision
 bool isPointInNegativeSide(const glm::dvec3& point, const Plane& plane);
-bool checkCollision(MassPoint* massPoint, BoundingBox* const bbox, glm::dvec3& closesPoint);
-void processCollisionResponse(Cube* const cube, MassPoint* const massPoint, const glm::dvec3& closestPoint);
-bool isPointInBox(glm::dvec3* const point, BoundingBox* const bbox);
+bool checkCollision(const glm::dvec3& position, BoundingBox* const bbox, glm::dvec3& closesPoint);
+template <typename Real>
+void processCollisionResponse(Cube* const cube, ParticleStore <Real>& particles, const int currentPoint, const glm::dvec3& closestPoint);
+bool isPointInBox(const glm::dvec3& point, BoundingBox* const bbox);
+template <typename Real>
+void computeBoxContactAcceleration(Cube* const cube, ParticleStore <Real>& particles);
+glm::dvec3 contactAcceleration(Cube* const cube, const glm::dvec3& position, const glm::dvec3& velocity, const glm::dvec3& closestPoint);
+glm::dvec3 computeContactAcceleration(Cube* const cube, const glm::dvec3& position, const glm::dvec3& velocity);
+double sweepBox(const glm::dvec3& from, const glm::dvec3& to, BoundingBox* const bbox, glm::dvec3& normal);
 
 #endif
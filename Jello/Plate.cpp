@@ -23,16 +23,29 @@ void Plate::setPosition(glm::vec3 position, double timeStep) {
 
     // move constraint points
     for (const auto& p : this->constraintPoints) {
-        p->setPosition(*p->getPosition() + posOffset);
+        this->cube->setPosition(p, this->cube->getPosition(p) + posOffset);
+        // position Verlet derives the velocity from the previous position, moving the points is all it needs
+        if (this->cube->velocityCurrent == false) {
+            continue;
+        }
         // change in position over change in time
         glm::vec3 vel = posOffset / timeStep;
 
-        p->setVelocity(vel);
+        if (glm::dvec3(vel) != this->cube->getVelocity(p)) {
+            // springs to the plate pull with the new velocity
+            this->cube->accelerationCurrent = false;
+        }
+        this->cube->setVelocity(p, vel);
+    }
+    if (posOffset != glm::dvec3(0.0) && !this->constraintPoints.empty()) {
+        // accelerations kept by velocity Verlet were found with the old positions
+        this->cube->accelerationCurrent = false;
     }
 
     platePlane->setPosition(position);
 }
 
-void Plate::setConstraintPoints(std::vector <MassPoint*> points) {
+void Plate::setConstraintPoints(Cube* cube, std::vector <int> points) {
+    this->cube = cube;
     this->constraintPoints = points;
 }
@@ -2,7 +2,7 @@
 #define __PLATE_H__
 
 #include "Plane.h"
-#include "MassPoint.h"
+#include "Cube.h"
 
 // movable plate that the bottom layer of the jello is constrained to
 class Plate {
@@ -13,9 +13,10 @@ public:
 
     float size = 1.0f;
     Plane* platePlane; // geometry
-    std::vector <MassPoint*> constraintPoints{}; // points that moving the plate will also move
+    Cube* cube = nullptr; // cube that owns the constraint points
+    std::vector <int> constraintPoints{}; // indices of points that moving the plate will also move
 
-    void setConstraintPoints(std::vector <MassPoint*> points);
+    void setConstraintPoints(Cube* cube, std::vector <int> points);
     void setPosition(glm::vec3 position, double timeStep);
 };
 
@@ -0,0 +1,112 @@
+#include "PositionVerletIntegrator.h"
+#include "Physics.h"
+
+// drops the previous positions and the step that led to them
+template <typename Real>
+void PositionVerletIntegrator<Real>::clear() {
+    this->buffers.clear();
+    this->lastStep = 0.0;
+}
+
+/**
+ * lays out the previous positions for the current topology
+ * @param const ParticleStore <Real>& current - the cube's particles
+ */
+template <typename Real>
+void PositionVerletIntegrator<Real>::prepare(const ParticleStore <Real>& current) {
+    const int count = current.size();
+    if (this->buffers.fits(count)) {
+        return;
+    }
+
+    Arena& arena = this->buffers.resize(count, 0, 3 * Arena::bytesFor<Real>(count));
+    this->previousX = arena.allocate<Real>(count);
+    this->previousY = arena.allocate<Real>(count);
+    this->previousZ = arena.allocate<Real>(count);
+}
+
+/**
+ * previous positions from the velocities another integrator (or a reset) left, x(t - dt) = x(t) - v(t) * dt
+ * @param const ParticleStore <Real>& p - the cube's particles
+ * @param double timeStep - dt
+ */
+template <typename Real>
+void PositionVerletIntegrator<Real>::start(const ParticleStore <Real>& p, double timeStep) {
+    const Real dt = Real(timeStep);
+
+    #pragma omp parallel for
+    for (int i = 0; i < p.size(); i++) {
+        this->previousX[i] = p.px[i] - p.vx[i] * dt;
+        this->previousY[i] = p.py[i] - p.vy[i] * dt;
+        this->previousZ[i] = p.pz[i] - p.vz[i] * dt;
+    }
+    this->lastStep = timeStep;
+}
+
+/**
+ * writes v = (x(t) - x(t - dt)) / dt into the particle store, for the damping forces and for
+ * whichever integrator runs after this one
+ * @param Cube* cube - cube the integrator belongs to
+ */
+template <typename Real>
+void PositionVerletIntegrator<Real>::deriveVelocity(Cube* cube) {
+    ParticleStore <Real>& p = cube->getParticles<Real>();
+    if (!this->buffers.fits(p.size()) || this->lastStep <= 0.0) {
+        return;
+    }
+    const Real inverseStep = Real(1.0 / this->lastStep);
+
+    #pragma omp parallel for
+    for (int i = 0; i < p.size(); i++) {
+        p.vx[i] = (p.px[i] - this->previousX[i]) * inverseStep;
+        p.vy[i] = (p.py[i] - this->previousY[i]) * inverseStep;
+        p.vz[i] = (p.pz[i] - this->previousZ[i]) * inverseStep;
+    }
+}
+
+/**
+ * performs one position Verlet step on the cube's particles, one force evaluation per step,
+ * velocities are only written while the damping is not 0
+ * @param Cube* cube - cube to integrate
+ * @param double timeStep - dt
+ */
+template <typename Real>
+void PositionVerletIntegrator<Real>::step(Cube* cube, double timeStep) {
+    ParticleStore <Real>& p = cube->getParticles<Real>();
+    this->prepare(p);
+
+    // the velocities belong to the current state, another integrator (or a reset) ran since the last step
+    if (cube->velocityCurrent) {
+        this->start(p, timeStep);
+        cube->velocityCurrent = false;
+    }
+
+    // damping forces read the velocities, a backward difference is enough for them
+    if (cube->damping != 0.0f) {
+        this->deriveVelocity(cube);
+    }
+    computeAcceleration <Real>(cube, p, timeStep);
+
+    const Real dt2 = Real(timeStep * timeStep);
+    const Real ratio = Real(timeStep / this->lastStep);
+
+    #pragma omp parallel for
+    for (int i = 0; i < p.size(); i++) {
+        const Real x = p.px[i], y = p.py[i], z = p.pz[i];
+
+        if (p.isFixed(i) == false) {
+            p.px[i] = x + (x - this->previousX[i]) * ratio + p.ax[i] * dt2;
+            p.py[i] = y + (y - this->previousY[i]) * ratio + p.ay[i] * dt2;
+            p.pz[i] = z + (z - this->previousZ[i]) * ratio + p.az[i] * dt2;
+        }
+
+        // fixed points stay, their next difference is what the plate moves them by
+        this->previousX[i] = x;
+        this->previousY[i] = y;
+        this->previousZ[i] = z;
+    }
+    this->lastStep = timeStep;
+}
+
+template class PositionVerletIntegrator <float>;
+template class PositionVerletIntegrator <double>;
@@ -0,0 +1,37 @@
+#ifndef __POSITIONVERLETINTEGRATOR_H__
+#define __POSITIONVERLETINTEGRATOR_H__
+
+#include "ParticleStore.h"
+
+class Cube;
+
+// position Verlet (Stormer) integrator, x(t + dt) = x(t) + (x(t) - x(t - dt)) + a(t) * dt^2
+// the state is the current and the previous position, velocity is only derived as (x(t) - x(t - dt)) / dt
+// while the damping (springs and walls) needs it, or when another integrator takes over (Cube::velocityCurrent)
+// points fixed to the plate keep their previous position too, so moving the plate only moves positions
+// a change of the step size between steps scales the position difference by the ratio of the steps
+// Real is the precision of the particles it integrates
+template <typename Real>
+class PositionVerletIntegrator {
+
+    public:
+        PositionVerletIntegrator() {}; // default constructor
+
+        void step(Cube* cube, double timeStep);
+        void deriveVelocity(Cube* cube);
+        void clear();
+
+    private:
+        // previous positions
+        ParticleBuffers buffers{};
+        // step that led from the previous to the current position
+        double lastStep = 0.0;
+
+        // positions one step back
+        Real *previousX = nullptr, *previousY = nullptr, *previousZ = nullptr;
+
+        void prepare(const ParticleStore <Real>& current);
+        void start(const ParticleStore <Real>& p, double timeStep);
+};
+
+#endif
@@ -0,0 +1,356 @@
+#include "ProjectiveDynamicsIntegrator.h"
+#include "Physics.h"
+
+#include <algorithm>
+#include <cmath>
+
+// parts of the nested dissection this small are ordered as they are
+static const int LEAF_SIZE = 32;
+
+template <typename Real>
+bool ProjectiveDynamicsIntegrator<Real>::Key::operator==(const Key& other) const {
+    for (int t = 0; t < SPRING_TYPE_COUNT; t++) {
+        if (this->typeStiffness[t] != other.typeStiffness[t]) {
+            return false;
+        }
+    }
+    return this->resolution == other.resolution && this->structural == other.structural && this->shear == other.shear
+        && this->bend == other.bend && this->order == other.order && this->springCount == other.springCount
+        && this->fixedHash == other.fixedHash && this->stiffness == other.stiffness && this->mass == other.mass
+        && this->timeStep == other.timeStep;
+}
+
+/**
+ * everything the system matrix of the current cube depends on
+ * @param Cube* cube - cube to integrate
+ * @param const ParticleStore <Real>& p - the cube's particles (fixed points)
+ * @param double timeStep - dt
+ * @return Key - cache key of the factor
+ */
+template <typename Real>
+typename ProjectiveDynamicsIntegrator<Real>::Key ProjectiveDynamicsIntegrator<Real>::makeKey(Cube* cube, const ParticleStore <Real>& p, double timeStep) const {
+    Key key;
+    key.resolution = cube->resolution;
+    key.structural = cube->structuralSpring;
+    key.shear = cube->shearSpring;
+    key.bend = cube->bendSpring;
+    key.order = cube->particleOrder;
+    key.springCount = cube->springs.size();
+    key.stiffness = cube->stiffness;
+    for (int t = 0; t < SPRING_TYPE_COUNT; t++) {
+        key.typeStiffness[t] = cube->springTypeStiffness[t];
+    }
+    key.mass = cube->mass;
+    key.timeStep = timeStep;
+
+    // FNV-1a over the indices of the fixed points
+    uint64_t hash = 14695981039346656037ull;
+    for (int i = 0; i < p.size(); i++) {
+        if (p.isFixed(i)) {
+            hash = (hash ^ uint64_t(i)) * 1099511628211ull;
+        }
+    }
+    key.fixedHash = hash;
+    return key;
+}
+
+/**
+ * recursive coordinate bisection with vertex separators (nested dissection) over the rest positions,
+ * a part is split at the median of its longest axis, points of the lower half with a spring into the upper
+ * half form the separator and are ordered after both halves, which keeps the fill of the factor small
+ * @param std::vector <int>& part - points to order, reordered in place
+ * @param const std::vector <glm::dvec3>& rest - rest position per point
+ * @param const std::vector <int>& adjacencyStart - neighbors of point p are adjacency[adjacencyStart[p] ..]
+ * @param const std::vector <int>& adjacency - free neighbors of every point, both directions
+ * @param std::vector <int>& side - -1 for every point on entry and on return
+ * @param std::vector <int>& order - output, points are appended in elimination order
+ */
+static void dissect(std::vector <int>& part, const std::vector <glm::dvec3>& rest, const std::vector <int>& adjacencyStart,
+    const std::vector <int>& adjacency, std::vector <int>& side, std::vector <int>& order) {
+    if (int(part.size()) <= LEAF_SIZE) {
+        order.insert(order.end(), part.begin(), part.end());
+        return;
+    }
+
+    // longest axis of the bounds
+    glm::dvec3 low = rest[part[0]], high = rest[part[0]];
+    for (const int p : part) {
+        low = glm::min(low, rest[p]);
+        high = glm::max(high, rest[p]);
+    }
+    const glm::dvec3 extent = high - low;
+    const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+    const size_t half = part.size() / 2;
+    std::nth_element(part.begin(), part.begin() + half, part.end(), [&](int a, int b) { return rest[a][axis] < rest[b][axis]; });
+    for (size_t i = 0; i < part.size(); i++) {
+        side[part[i]] = i < half ? 0 : 1;
+    }
+
+    std::vector <int> lower, upper, separator;
+    for (size_t i = 0; i < half; i++) {
+        const int p = part[i];
+        bool crossing = false;
+        for (int n = adjacencyStart[p]; n < adjacencyStart[p + 1] && !crossing; n++) {
+            crossing = side[adjacency[n]] == 1;
+        }
+        (crossing ? separator : lower).push_back(p);
+    }
+    upper.assign(part.begin() + half, part.end());
+    for (const int p : part) {
+        side[p] = -1;
+    }
+
+    dissect(lower, rest, adjacencyStart, adjacency, side, order);
+    dissect(upper, rest, adjacencyStart, adjacency, side, order);
+    order.insert(order.end(), separator.begin(), separator.end());
+}
+
+/**
+ * numbers the free points in nested dissection order
+ * @param Cube* cube - cube to integrate
+ * @param const ParticleStore <Real>& p - the cube's particles
+ */
+template <typename Real>
+void ProjectiveDynamicsIntegrator<Real>::orderPoints(Cube* cube, const ParticleStore <Real>& p) {
+    const SpringTable& springs = cube->springs;
+    const int count = p.size();
+
+    // free to free springs in both directions
+    std::vector <int> adjacencyStart(count + 1, 0);
+    for (int s = 0; s < springs.size(); s++) {
+        if (!p.isFixed(springs.pointA[s]) && !p.isFixed(springs.pointB[s])) {
+            adjacencyStart[springs.pointA[s] + 1]++;
+            adjacencyStart[springs.pointB[s] + 1]++;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        adjacencyStart[i + 1] += adjacencyStart[i];
+    }
+    std::vector <int> adjacency(adjacencyStart[count]);
+    std::vector <int> next(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (int s = 0; s < springs.size(); s++) {
+        const int a = springs.pointA[s];
+        const int b = springs.pointB[s];
+        if (!p.isFixed(a) && !p.isFixed(b)) {
+            adjacency[next[a]++] = b;
+            adjacency[next[b]++] = a;
+        }
+    }
+
+    std::vector <glm::dvec3> rest(count);
+    std::vector <int> part;
+    for (int i = 0; i < count; i++) {
+        rest[i] = glm::dvec3(p.getInitialPosition(i));
+        if (!p.isFixed(i)) {
+            part.push_back(i);
+        }
+    }
+
+    std::vector <int> side(count, -1);
+    this->point.clear();
+    this->point.reserve(part.size());
+    dissect(part, rest, adjacencyStart, adjacency, side, this->point);
+
+    this->column.assign(count, -1);
+    for (int c = 0; c < int(this->point.size()); c++) {
+        this->column[this->point[c]] = c;
+    }
+}
+
+/**
+ * builds and factors the system matrix M / dt^2 + sum k * (e_a - e_b)(e_a - e_b)^T over the free points
+ * @param Cube* cube - cube to integrate
+ * @param const ParticleStore <Real>& p - the cube's particles
+ * @param double timeStep - dt
+ * @return bool - false if the factorization failed
+ */
+template <typename Real>
+bool ProjectiveDynamicsIntegrator<Real>::factor(Cube* cube, const ParticleStore <Real>& p, double timeStep) {
+    const SpringTable& springs = cube->springs;
+    this->orderPoints(cube, p);
+    const int size = int(this->point.size());
+
+    // upper triangle entries (row <= column) per column, duplicates are summed by the factorization
+    std::vector <int> entries(size + 1, 0);
+    for (int c = 0; c < size; c++) {
+        entries[c + 1]++;
+    }
+    for (int s = 0; s < springs.size(); s++) {
+        const int a = this->column[springs.pointA[s]];
+        const int b = this->column[springs.pointB[s]];
+        if (a >= 0 && b >= 0) {
+            entries[std::max(a, b) + 1]++;
+        }
+    }
+    for (int c = 0; c < size; c++) {
+        entries[c + 1] += entries[c];
+    }
+    std::vector <int> rows(entries[size]);
+    std::vector <double> values(entries[size]);
+    std::vector <int> next(entries.begin(), entries.end() - 1);
+
+    // diagonal: mass / dt^2 plus the stiffness of every spring at the point (fixed neighbors included)
+    const double inertia = double(cube->mass) / (timeStep * timeStep);
+    std::vector <double> diagonal(size, inertia);
+    for (int s = 0; s < springs.size(); s++) {
+        const double k = double(cube->stiffness) * double(cube->springTypeStiffness[springs.type[s]]);
+        const int a = this->column[springs.pointA[s]];
+        const int b = this->column[springs.pointB[s]];
+        if (a >= 0) {
+            diagonal[a] += k;
+        }
+        if (b >= 0) {
+            diagonal[b] += k;
+        }
+        if (a >= 0 && b >= 0) {
+            const int n = next[std::max(a, b)]++;
+            rows[n] = std::min(a, b);
+            values[n] = -k;
+        }
+    }
+    for (int c = 0; c < size; c++) {
+        const int n = next[c]++;
+        rows[n] = c;
+        values[n] = diagonal[c];
+    }
+
+    if (!this->cholesky.factor(size, entries, rows, values)) {
+        return false;
+    }
+    ProjectiveDynamicsStats& stats = cube->pdStats;
+    stats.unknowns = size;
+    stats.nonZeros = (long long)(this->cholesky.nonZeros());
+    stats.factorizations++;
+
+    this->inertia.assign(3 * size_t(size), 0.0);
+    this->rhs.assign(3 * size_t(size), 0.0);
+    for (int c = 0; c < 3; c++) {
+        this->projection[c].assign(springs.size(), 0.0);
+        this->previous[c].assign(p.size(), 0.0);
+    }
+    return true;
+}
+
+/**
+ * local step: every spring vector projected to its rest length along its current direction
+ * @param Cube* cube - cube to integrate
+ * @param const ParticleStore <Real>& p - current estimate of the positions
+ */
+template <typename Real>
+void ProjectiveDynamicsIntegrator<Real>::project(Cube* cube, const ParticleStore <Real>& p) {
+    const SpringTable& springs = cube->springs;
+
+    #pragma omp parallel for
+    for (int s = 0; s < springs.size(); s++) {
+        const glm::dvec3 L = glm::dvec3(p.getPosition(springs.pointA[s]) - p.getPosition(springs.pointB[s]));
+        const double length = glm::length(L);
+        const glm::dvec3 d = length > 0.0 ? L * (springs.restLength[s] / length) : glm::dvec3(0.0);
+        this->projection[0][s] = d.x;
+        this->projection[1][s] = d.y;
+        this->projection[2][s] = d.z;
+    }
+}
+
+/**
+ * global right hand side: M / dt^2 * y + sum k * (e_a - e_b) * d, springs to fixed points add k * x_fixed
+ * @param Cube* cube - cube to integrate
+ * @param const ParticleStore <Real>& p - the cube's particles (positions of the fixed points)
+ */
+template <typename Real>
+void ProjectiveDynamicsIntegrator<Real>::assembleRhs(Cube* cube, const ParticleStore <Real>& p) {
+    const SpringTable& springs = cube->springs;
+    std::copy(this->inertia.begin(), this->inertia.end(), this->rhs.begin());
+
+    springs.forEachColored([&](int s) {
+        const double k = double(cube->stiffness) * double(cube->springTypeStiffness[springs.type[s]]);
+        const int pointA = springs.pointA[s];
+        const int pointB = springs.pointB[s];
+        const int a = this->column[pointA];
+        const int b = this->column[pointB];
+        const glm::dvec3 d = glm::dvec3(this->projection[0][s], this->projection[1][s], this->projection[2][s]);
+
+        if (a >= 0) {
+            const glm::dvec3 pull = b >= 0 ? k * d : k * (d + glm::dvec3(p.getPosition(pointB)));
+            this->rhs[3 * a] += pull.x; this->rhs[3 * a + 1] += pull.y; this->rhs[3 * a + 2] += pull.z;
+        }
+        if (b >= 0) {
+            const glm::dvec3 pull = a >= 0 ? -k * d : k * (glm::dvec3(p.getPosition(pointA)) - d);
+            this->rhs[3 * b] += pull.x; this->rhs[3 * b + 1] += pull.y; this->rhs[3 * b + 2] += pull.z;
+        }
+    });
+}
+
+/**
+ * performs one projective dynamics step on the cube's particles with cube->pdIterations local / global
+ * iterations, the bounding box is applied as a projection afterwards and the velocity is the change in position
+ * @param Cube* cube - cube to integrate
+ * @param double timeStep - dt
+ */
+template <typename Real>
+void ProjectiveDynamicsIntegrator<Real>::step(Cube* cube, double timeStep) {
+    ParticleStore <Real>& p = cube->getParticles<Real>();
+    const Key current = this->makeKey(cube, p, timeStep);
+    if (!(current == this->key)) {
+        if (!this->factor(cube, p, timeStep)) {
+            this->key = Key();
+            return;
+        }
+        this->key = current;
+    }
+
+    const int size = int(this->point.size());
+    const double inertia = double(cube->mass) / (timeStep * timeStep);
+    const glm::dvec3 externalAcc = cube->externalForce / double(cube->mass);
+    // contacts with the other cubes of the world, held over the step like in computeAcceleration
+    const glm::dvec3* bodyContact = cube->bodyContacts > 0 ? cube->bodyContact.data() : nullptr;
+
+    // inertial prediction y = x + dt * v + dt^2 * (a_external + a_contact), also the first estimate
+    #pragma omp parallel for
+    for (int c = 0; c < size; c++) {
+        const int i = this->point[c];
+        const glm::dvec3 x = glm::dvec3(p.getPosition(i));
+        const glm::dvec3 acceleration = bodyContact != nullptr ? externalAcc + bodyContact[i] : externalAcc;
+        const glm::dvec3 y = x + timeStep * glm::dvec3(p.getVelocity(i)) + timeStep * timeStep * acceleration;
+        this->previous[0][i] = x.x; this->previous[1][i] = x.y; this->previous[2][i] = x.z;
+        this->inertia[3 * c] = inertia * y.x; this->inertia[3 * c + 1] = inertia * y.y; this->inertia[3 * c + 2] = inertia * y.z;
+        p.setPosition(i, glm::vec<3, Real>(y));
+    }
+
+    for (int it = 0; it < std::max(1, cube->pdIterations); it++) {
+        this->project(cube, p);
+        this->assembleRhs(cube, p);
+
+        // one forward and one back substitution for all three coordinates
+        this->cholesky.solve(this->rhs.data(), 3);
+
+        #pragma omp parallel for
+        for (int c = 0; c < size; c++) {
+            const int i = this->point[c];
+            p.setPosition(i, glm::vec<3, Real>(glm::dvec3(this->rhs[3 * c], this->rhs[3 * c + 1], this->rhs[3 * c + 2])));
+        }
+    }
+
+    // self collision, obstacles and the bounding box as hard projections, then the velocity from the change in position
+    if (cube->selfCollision) {
+        cube->getSelfCollider<Real>().project(cube, p);
+    }
+    if (colliders != nullptr) {
+        colliders->project(p);
+    }
+    const glm::dvec3 low = glm::dvec3(boundingBox->minX, boundingBox->minY, boundingBox->minZ);
+    const glm::dvec3 high = glm::dvec3(boundingBox->maxX, boundingBox->maxY, boundingBox->maxZ);
+    #pragma omp parallel for
+    for (int c = 0; c < size; c++) {
+        const int i = this->point[c];
+        const glm::dvec3 x = glm::clamp(glm::dvec3(p.getPosition(i)), low, high);
+        const glm::dvec3 start = glm::dvec3(this->previous[0][i], this->previous[1][i], this->previous[2][i]);
+        p.setPosition(i, glm::vec<3, Real>(x));
+        p.setVelocity(i, glm::vec<3, Real>((x - start) / timeStep));
+    }
+
+    applySpringDamping <Real>(cube, p, Real(timeStep));
+}
+
+template class ProjectiveDynamicsIntegrator <float>;
+template class ProjectiveDynamicsIntegrator <double>;
@@ -0,0 +1,75 @@
+#ifndef __PROJECTIVEDYNAMICSINTEGRATOR_H__
+#define __PROJECTIVEDYNAMICSINTEGRATOR_H__
+
+#include <vector>
+#include <cstdint>
+
+#include "ParticleStore.h"
+#include "SpringTable.h"
+#include "SparseCholesky.h"
+
+class Cube;
+
+// the cached factor, shown in the ui
+struct ProjectiveDynamicsStats {
+    // size of the factored system, nonzeros of its Cholesky factor, and factorizations since the start
+    int unknowns = 0;
+    long long nonZeros = 0;
+    int factorizations = 0;
+};
+
+// projective dynamics integrator (implicit Euler on the spring energy, solved by local / global iterations)
+// local step: every spring projects its current direction onto its rest length, independent per spring
+// global step: (M / dt^2 + L) x = M / dt^2 * y + J * d, a constant sparse system (L is the spring graph
+// weighted by stiffness) that is factored once and then only needs forward and back substitution
+// points fixed to the plate are not unknowns, their springs pull on the right hand side
+// the factor is cached against everything the matrix depends on (resolution, spring types, particle order,
+// fixed points, stiffness, mass and time step), so a reset of the same cube does not refactor
+// Real is the precision of the particles it integrates, the factor and solves are always double
+template <typename Real>
+class ProjectiveDynamicsIntegrator {
+
+    public:
+        ProjectiveDynamicsIntegrator() {}; // default constructor
+
+        void step(Cube* cube, double timeStep);
+
+    private:
+        // everything the system matrix depends on
+        struct Key {
+            int resolution = -1;
+            bool structural = false, shear = false, bend = false;
+            int order = -1;
+            int springCount = -1;
+            uint64_t fixedHash = 0;
+            float stiffness = 0.0f;
+            float typeStiffness[SPRING_TYPE_COUNT] = {};
+            float mass = 0.0f;
+            double timeStep = 0.0;
+
+            bool operator==(const Key& other) const;
+        };
+        Key key{};
+        SparseCholesky cholesky{};
+
+        // column of every free point in the factored (fill reducing) order, -1 for fixed points
+        std::vector <int> column{};
+        // point of every column
+        std::vector <int> point{};
+
+        // M / dt^2 * y, right hand side and solution, xyz interleaved per column (solved in one pass)
+        std::vector <double> inertia{};
+        std::vector <double> rhs{};
+        // projected spring vector (rest length along the current direction) per spring
+        std::vector <double> projection[3]{};
+        // positions at the start of the step per point
+        std::vector <double> previous[3]{};
+
+        Key makeKey(Cube* cube, const ParticleStore <Real>& p, double timeStep) const;
+        bool factor(Cube* cube, const ParticleStore <Real>& p, double timeStep);
+        void orderPoints(Cube* cube, const ParticleStore <Real>& p);
+        void project(Cube* cube, const ParticleStore <Real>& p);
+        void assembleRhs(Cube* cube, const ParticleStore <Real>& p);
+};
+
+#endif
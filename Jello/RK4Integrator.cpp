@@ -0,0 +1,129 @@
+#include "RK4Integrator.h"
+#include "Physics.h"
+
+template <typename Real>
+void RK4Integrator<Real>::clear() {
+    this->buffers.clear();
+    this->stage.clear();
+}
+
+/**
+ * lays out the stage state and the derivative sums for the current topology
+ * @param const ParticleStore <Real>& current - state at the start of the step
+ */
+template <typename Real>
+void RK4Integrator<Real>::prepare(const ParticleStore <Real>& current) {
+    const int count = current.size();
+    if (!this->buffers.fits(count)) {
+        Arena& arena = this->buffers.resize(count, 0, ParticleStore <Real>::bytesFor(count) + 6 * Arena::bytesFor<Real>(count));
+        this->stage.allocate(arena, count);
+
+        Real** sums[6] = { &dpx, &dpy, &dpz, &dvx, &dvy, &dvz };
+        for (Real** sum : sums) {
+            *sum = arena.allocate<Real>(count);
+        }
+    }
+
+    // fixed points may change with the topology while the point count stays the same
+    this->stage.copyFlags(current);
+}
+
+/**
+ * accumulates one stage derivative and writes the state the next stage is evaluated at
+ * stage = current + stageFraction * dt * k
+ * @param const ParticleStore <Real>& current - state at the start of the step
+ * @param const ParticleStore <Real>& derivative - state holding the velocity and acceleration of this stage (k)
+ * @param Real timeStep - dt
+ * @param Real stageFraction - fraction of dt to the next stage (0.5 or 1.0)
+ * @param Real weight - weight of k in the final sum (1 or 2)
+ * @param bool first - k1 starts the sum
+ */
+template <typename Real>
+void RK4Integrator<Real>::addStage(const ParticleStore <Real>& current, const ParticleStore <Real>& derivative, Real timeStep, Real stageFraction, Real weight, bool first) {
+    ParticleStore <Real>& s = this->stage;
+
+    // derivative can be the stage itself, every point reads its own k before overwriting it
+    #pragma omp parallel for
+    for (int i = 0; i < current.size(); i++) {
+        // Position
+        const Real kpx = derivative.vx[i] * timeStep;
+        const Real kpy = derivative.vy[i] * timeStep;
+        const Real kpz = derivative.vz[i] * timeStep;
+        // Velocity
+        const Real kvx = derivative.ax[i] * timeStep;
+        const Real kvy = derivative.ay[i] * timeStep;
+        const Real kvz = derivative.az[i] * timeStep;
+
+        if (first) {
+            this->dpx[i] = kpx; this->dpy[i] = kpy; this->dpz[i] = kpz;
+            this->dvx[i] = kvx; this->dvy[i] = kvy; this->dvz[i] = kvz;
+        }
+        else {
+            this->dpx[i] += kpx * weight; this->dpy[i] += kpy * weight; this->dpz[i] += kpz * weight;
+            this->dvx[i] += kvx * weight; this->dvy[i] += kvy * weight; this->dvz[i] += kvz * weight;
+        }
+
+        if (current.isFixed(i) == true) {
+            // no change
+            s.px[i] = current.px[i]; s.py[i] = current.py[i]; s.pz[i] = current.pz[i];
+            s.vx[i] = current.vx[i]; s.vy[i] = current.vy[i]; s.vz[i] = current.vz[i];
+        }
+        else {
+            s.px[i] = current.px[i] + kpx * stageFraction;
+            s.py[i] = current.py[i] + kpy * stageFraction;
+            s.pz[i] = current.pz[i] + kpz * stageFraction;
+            s.vx[i] = current.vx[i] + kvx * stageFraction;
+            s.vy[i] = current.vy[i] + kvy * stageFraction;
+            s.vz[i] = current.vz[i] + kvz * stageFraction;
+        }
+    }
+}
+
+/**
+ * performs one Runge-Kutta 4th order step on the cube's particles
+ * @param Cube* cube - cube to integrate
+ * @param double timeStep - dt
+ */
+template <typename Real>
+void RK4Integrator<Real>::step(Cube* cube, double timeStep) {
+    ParticleStore <Real>& current = cube->getParticles<Real>();
+    const Real dt = Real(timeStep);
+    this->prepare(current);
+
+    // 1st step: k1 = F(t0, x0)
+    computeAcceleration <Real>(cube, current, timeStep);
+    this->addStage(current, current, dt, Real(0.5), Real(1), true);
+
+    // 2nd step: k2 = F(t + dt/2, x + h * k1/2)
+    computeAcceleration <Real>(cube, this->stage, timeStep);
+    this->addStage(current, this->stage, dt, Real(0.5), Real(2), false);
+
+    // 3rd step: k3 = F(t + dt/2, x + h * k2/2)
+    computeAcceleration <Real>(cube, this->stage, timeStep);
+    this->addStage(current, this->stage, dt, Real(1), Real(2), false);
+
+    // 4th step: k4 = F(t + dt, x + h * k3)
+    computeAcceleration <Real>(cube, this->stage, timeStep);
+
+    const ParticleStore <Real>& s = this->stage;
+
+    #pragma omp parallel for
+    for (int i = 0; i < current.size(); i++) {
+        if (current.isFixed(i) == true) {
+            // no change
+            continue;
+        }
+
+        // dx = dt * (k1 + 2 * k2 + 2* k3 + k4)/6
+        // x = x + dx
+        current.px[i] += (this->dpx[i] + s.vx[i] * dt) / Real(6);
+        current.py[i] += (this->dpy[i] + s.vy[i] * dt) / Real(6);
+        current.pz[i] += (this->dpz[i] + s.vz[i] * dt) / Real(6);
+        current.vx[i] += (this->dvx[i] + s.ax[i] * dt) / Real(6);
+        current.vy[i] += (this->dvy[i] + s.ay[i] * dt) / Real(6);
+        current.vz[i] += (this->dvz[i] + s.az[i] * dt) / Real(6);
+    }
+}
+
+template class RK4Integrator <float>;
+template class RK4Integrator <double>;
@@ -0,0 +1,32 @@
+#ifndef __RK4INTEGRATOR_H__
+#define __RK4INTEGRATOR_H__
+
+#include "ParticleStore.h"
+
+class Cube;
+
+// Runge-Kutta 4th order integrator that owns its stage state
+// Real is the precision of the particles it integrates
+template <typename Real>
+class RK4Integrator {
+
+    public:
+        RK4Integrator() {}; // default constructor
+
+        void step(Cube* cube, double timeStep);
+        void clear();
+
+    private:
+        // stage state and derivative sums
+        ParticleBuffers buffers{};
+        // intermediate state the stage derivatives are evaluated at
+        ParticleStore <Real> stage{};
+        // weighted sum of the stage derivatives times dt, k1 + 2 * k2 + 2 * k3 + k4
+        Real *dpx = nullptr, *dpy = nullptr, *dpz = nullptr;
+        Real *dvx = nullptr, *dvy = nullptr, *dvz = nullptr;
+
+        void prepare(const ParticleStore <Real>& current);
+        void addStage(const ParticleStore <Real>& current, const ParticleStore <Real>& derivative, Real timeStep, Real stageFraction, Real weight, bool first);
+};
+
+#endif
@@ -0,0 +1,503 @@
+#include "SelfCollider.h"
+#include "Physics.h"
+
+#include <algorithm>
+#include <cmath>
+
+// drops the buffers, the surface and the triangles
+template <typename Real>
+void SelfCollider<Real>::clear() {
+    this->buffers.clear();
+    this->surfaceCount = 0;
+    this->triangleCount = 0;
+}
+
+// calls f(a, b, c) for the two triangles of every quad of the faces, split like Cube::render
+template <typename F>
+static void forEachFaceTriangle(Cube* cube, const F& f) {
+    const int res = cube->resolution;
+    for (const std::vector <int>* face : cube->frontFaces) {
+        const int size = int(face->size());
+        for (int q = 0; q < size; q++) {
+            if ((q + 1) % res != 0 && q + res < size) {
+                f((*face)[q], (*face)[q + 1], (*face)[q + res]);
+                f((*face)[q + 1], (*face)[q + 1 + res], (*face)[q + res]);
+            }
+        }
+    }
+    for (const std::vector <int>* face : cube->backFaces) {
+        const int size = int(face->size());
+        for (int q = 0; q < size; q++) {
+            if ((q + 1) % res != 0 && q + res < size) {
+                f((*face)[q + res], (*face)[q + 1], (*face)[q]);
+                f((*face)[q + res], (*face)[q + 1 + res], (*face)[q + 1]);
+            }
+        }
+    }
+}
+
+/**
+ * lists the surface points and triangles and sizes the hash, only when the point count changed
+ * (the cube clears it on every rebuild of the topology)
+ * @param Cube* cube - cube with the faces
+ * @param const ParticleStore <Real>& p - the cube's particles
+ */
+template <typename Real>
+void SelfCollider<Real>::prepare(Cube* cube, const ParticleStore <Real>& p) {
+    const int count = p.size();
+    if (this->buffers.fits(count)) {
+        return;
+    }
+
+    int surfaceCount = 0;
+    for (int i = 0; i < count; i++) {
+        surfaceCount += p.isSurfacePoint(i) ? 1 : 0;
+    }
+    int triangleCount = 0;
+    forEachFaceTriangle(cube, [&](int, int, int) { triangleCount++; });
+
+    const int blocks = std::max(1, omp_get_max_threads());
+    const int tableSize = std::max(1, 2 * triangleCount);
+
+    Arena& arena = this->buffers.resize(count, 0, Arena::bytesFor<int>(surfaceCount) + Arena::bytesFor<int>(3 * size_t(triangleCount))
+        + 2 * Arena::bytesFor<int>(triangleCount) + Arena::bytesFor<int>(size_t(tableSize) + 1)
+        + Arena::bytesFor<int>(size_t(blocks) * tableSize) + Arena::bytesFor<double>(blocks)
+        + 3 * Arena::bytesFor<Real>(triangleCount) + 3 * Arena::bytesFor<Real>(surfaceCount)
+        + Arena::bytesFor<Contact>(size_t(CONTACT_SLOTS) * surfaceCount) + Arena::bytesFor<int>(surfaceCount));
+    this->surface = arena.allocate<int>(surfaceCount);
+    this->triangles = arena.allocate<int>(3 * size_t(triangleCount));
+    this->bucket = arena.allocate<int>(triangleCount);
+    this->sorted = arena.allocate<int>(triangleCount);
+    this->bucketStart = arena.allocate<int>(size_t(tableSize) + 1);
+    this->counts = arena.allocate<int>(size_t(blocks) * tableSize);
+    this->blockRadius = arena.allocate<double>(blocks);
+    this->centroidX = arena.allocate<Real>(triangleCount);
+    this->centroidY = arena.allocate<Real>(triangleCount);
+    this->centroidZ = arena.allocate<Real>(triangleCount);
+    this->correctionX = arena.allocate<Real>(surfaceCount);
+    this->correctionY = arena.allocate<Real>(surfaceCount);
+    this->correctionZ = arena.allocate<Real>(surfaceCount);
+    this->contactSlots = arena.allocate<Contact>(size_t(CONTACT_SLOTS) * surfaceCount);
+    this->contactCounts = arena.allocate<int>(surfaceCount);
+    std::fill(this->correctionX, this->correctionX + surfaceCount, Real(0));
+    std::fill(this->correctionY, this->correctionY + surfaceCount, Real(0));
+    std::fill(this->correctionZ, this->correctionZ + surfaceCount, Real(0));
+
+    this->surfaceCount = 0;
+    for (int i = 0; i < count; i++) {
+        if (p.isSurfacePoint(i)) {
+            this->surface[this->surfaceCount++] = i;
+        }
+    }
+    // the normal of every triangle points out of the cube at rest, so other cubes can tell inside from outside
+    glm::dvec3 center = glm::dvec3(0.0);
+    for (int s = 0; s < this->surfaceCount; s++) {
+        center += glm::dvec3(p.getInitialPosition(this->surface[s]));
+    }
+    center /= double(std::max(1, this->surfaceCount));
+    this->triangleCount = 0;
+    forEachFaceTriangle(cube, [&](int a, int b, int c) {
+        const glm::dvec3 restA = glm::dvec3(p.getInitialPosition(a));
+        const glm::dvec3 restB = glm::dvec3(p.getInitialPosition(b));
+        const glm::dvec3 restC = glm::dvec3(p.getInitialPosition(c));
+        if (glm::dot(glm::cross(restB - restA, restC - restA), restA + restB + restC - 3.0 * center) < 0.0) {
+            std::swap(b, c);
+        }
+        int* corner = this->triangles + 3 * size_t(this->triangleCount++);
+        corner[0] = a; corner[1] = b; corner[2] = c;
+    });
+
+    this->blocks = blocks;
+    this->tableSize = tableSize;
+}
+
+// first triangle of block b when count triangles are split into blocks of (almost) equal size
+static int blockStart(int count, int b, int blocks) {
+    return int((long long)(count) * b / blocks);
+}
+
+template <typename Real>
+int SelfCollider<Real>::hash(const glm::ivec3& cell) const {
+    const unsigned int h = (unsigned int)(cell.x) * 92837111u ^ (unsigned int)(cell.y) * 689287499u ^ (unsigned int)(cell.z) * 283923481u;
+    return int(h % (unsigned int)(this->tableSize));
+}
+
+/**
+ * rebuilds the spatial hash of the triangle centroids for the current positions
+ * @param const ParticleStore <Real>& p - the cube's particles
+ * @param double thickness - largest contact distance the queries will use
+ */
+template <typename Real>
+void SelfCollider<Real>::build(const ParticleStore <Real>& p, double thickness) {
+    const int T = this->triangleCount;
+    const int blocks = this->blocks;
+    const int tableSize = this->tableSize;
+
+    // centroids and the largest triangle of every block
+    #pragma omp parallel for
+    for (int b = 0; b < blocks; b++) {
+        const int first = blockStart(T, b, blocks);
+        const int last = blockStart(T, b + 1, blocks);
+        double radius2 = 0.0;
+        for (int t = first; t < last; t++) {
+            const int* corner = this->triangles + 3 * size_t(t);
+            const glm::dvec3 a = glm::dvec3(p.getPosition(corner[0]));
+            const glm::dvec3 bb = glm::dvec3(p.getPosition(corner[1]));
+            const glm::dvec3 c = glm::dvec3(p.getPosition(corner[2]));
+            const glm::dvec3 centroid = (a + bb + c) / 3.0;
+            radius2 = std::max(radius2, std::max(glm::distance2(a, centroid), std::max(glm::distance2(bb, centroid), glm::distance2(c, centroid))));
+            this->centroidX[t] = Real(centroid.x); this->centroidY[t] = Real(centroid.y); this->centroidZ[t] = Real(centroid.z);
+        }
+        this->blockRadius[b] = std::sqrt(radius2);
+    }
+    this->radius = *std::max_element(this->blockRadius, this->blockRadius + blocks);
+
+    // a point within the thickness of a triangle is at most one cell away from its centroid (with room for rounding)
+    this->cellSize = std::max(1.01 * (this->radius + thickness), 1e-9);
+    const double inverseCell = 1.0 / this->cellSize;
+
+    // count per block
+    #pragma omp parallel for
+    for (int b = 0; b < blocks; b++) {
+        const int first = blockStart(T, b, blocks);
+        const int last = blockStart(T, b + 1, blocks);
+        int* row = this->counts + size_t(b) * tableSize;
+        std::fill(row, row + tableSize, 0);
+        for (int t = first; t < last; t++) {
+            const glm::ivec3 cell = glm::ivec3(glm::floor(glm::dvec3(this->centroidX[t], this->centroidY[t], this->centroidZ[t]) * inverseCell));
+            this->bucket[t] = this->hash(cell);
+            row[this->bucket[t]]++;
+        }
+    }
+
+    // rows become the offset of every block inside its bucket, then the prefix sum over the buckets
+    #pragma omp parallel for
+    for (int h = 0; h < tableSize; h++) {
+        int total = 0;
+        for (int b = 0; b < blocks; b++) {
+            const int count = this->counts[size_t(b) * tableSize + h];
+            this->counts[size_t(b) * tableSize + h] = total;
+            total += count;
+        }
+        this->bucketStart[h + 1] = total;
+    }
+    this->bucketStart[0] = 0;
+    for (int h = 0; h < tableSize; h++) {
+        this->bucketStart[h + 1] += this->bucketStart[h];
+    }
+
+    // scatter, every block keeps its triangles in order
+    #pragma omp parallel for
+    for (int b = 0; b < blocks; b++) {
+        const int first = blockStart(T, b, blocks);
+        const int last = blockStart(T, b + 1, blocks);
+        int* row = this->counts + size_t(b) * tableSize;
+        for (int t = first; t < last; t++) {
+            const int h = this->bucket[t];
+            this->sorted[this->bucketStart[h] + row[h]++] = t;
+        }
+    }
+}
+
+/**
+ * closest point of a triangle to a point (Ericson, Real-Time Collision Detection 5.1.5)
+ * @param const glm::dvec3& p - point
+ * @param const glm::dvec3& a, b, c - corners
+ * @param glm::dvec3& weights - barycentric weights of the closest point
+ * @return glm::dvec3 - closest point
+ */
+static glm::dvec3 closestPointOnTriangle(const glm::dvec3& p, const glm::dvec3& a, const glm::dvec3& b, const glm::dvec3& c, glm::dvec3& weights) {
+    const glm::dvec3 ab = b - a, ac = c - a, ap = p - a;
+    const double d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0 && d2 <= 0.0) {
+        weights = glm::dvec3(1.0, 0.0, 0.0);
+        return a;
+    }
+    const glm::dvec3 bp = p - b;
+    const double d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0 && d4 <= d3) {
+        weights = glm::dvec3(0.0, 1.0, 0.0);
+        return b;
+    }
+    const double vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) {
+        const double v = d1 / (d1 - d3);
+        weights = glm::dvec3(1.0 - v, v, 0.0);
+        return a + v * ab;
+    }
+    const glm::dvec3 cp = p - c;
+    const double d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0 && d5 <= d6) {
+        weights = glm::dvec3(0.0, 0.0, 1.0);
+        return c;
+    }
+    const double vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) {
+        const double w = d2 / (d2 - d6);
+        weights = glm::dvec3(1.0 - w, 0.0, w);
+        return a + w * ac;
+    }
+    const double va = d3 * d6 - d5 * d4;
+    if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0) {
+        const double w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        weights = glm::dvec3(0.0, 1.0 - w, w);
+        return b + w * (c - b);
+    }
+    const double denominator = 1.0 / (va + vb + vc);
+    const double v = vb * denominator, w = vc * denominator;
+    weights = glm::dvec3(1.0 - v - w, v, w);
+    return a + ab * v + ac * w;
+}
+
+/**
+ * calls f(t, normal, depth, weights) for every triangle t closer than the thickness to the point,
+ * skipping the triangles skip(corners) is true for
+ * @param const ParticleStore <Real>& p - particles of the triangles
+ * @param const glm::dvec3& x - query point
+ * @param double thickness - contact distance, at most the thickness the hash was built for
+ * @param const S& skip - filter on the corners of a triangle
+ * @param const F& f - contact callback
+ * @return int - triangles in contact
+ */
+template <typename Real>
+template <typename S, typename F>
+int SelfCollider<Real>::forEachNearTriangle(const ParticleStore <Real>& p, const glm::dvec3& x, double thickness, double inside, const S& skip, const F& f) const {
+    const double reach2 = (this->radius + thickness + inside) * (this->radius + thickness + inside);
+    const glm::ivec3 cell = glm::ivec3(glm::floor(x / this->cellSize));
+
+    // neighboring cells can share a bucket, every bucket is visited once
+    int visited[27];
+    int visitedCount = 0;
+    int contacts = 0;
+
+    for (int dz = -1; dz <= 1; dz++) {
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                const int h = this->hash(cell + glm::ivec3(dx, dy, dz));
+                if (std::find(visited, visited + visitedCount, h) != visited + visitedCount) {
+                    continue;
+                }
+                visited[visitedCount++] = h;
+
+                for (int e = this->bucketStart[h]; e < this->bucketStart[h + 1]; e++) {
+                    const int t = this->sorted[e];
+                    const glm::dvec3 centroid = glm::dvec3(this->centroidX[t], this->centroidY[t], this->centroidZ[t]);
+                    if (glm::distance2(x, centroid) > reach2) {
+                        continue;
+                    }
+
+                    const int* corner = this->triangles + 3 * size_t(t);
+                    if (skip(corner)) {
+                        continue;
+                    }
+
+                    const glm::dvec3 a = glm::dvec3(p.getPosition(corner[0]));
+                    const glm::dvec3 b = glm::dvec3(p.getPosition(corner[1]));
+                    const glm::dvec3 c = glm::dvec3(p.getPosition(corner[2]));
+                    glm::dvec3 weights;
+                    const glm::dvec3 L = x - closestPointOnTriangle(x, a, b, c, weights);
+                    const double distance2 = glm::dot(L, L);
+
+                    // points of other cubes know the outside: behind the triangle and straight under it the point is
+                    // inside the cube and goes out along the normal, elsewhere behind it the neighboring faces push
+                    if (inside > 0.0) {
+                        const glm::dvec3 face = glm::cross(b - a, c - a);
+                        const double side = glm::dot(L, face);
+                        if (side < 0.0) {
+                            if (distance2 < inside * inside && side * side >= 0.999 * distance2 * glm::dot(face, face)) {
+                                f(t, face / glm::length(face), thickness + std::sqrt(distance2), weights);
+                                contacts++;
+                            }
+                            continue;
+                        }
+                    }
+                    if (distance2 >= thickness * thickness) {
+                        continue;
+                    }
+
+                    // away from the triangle, along its normal when the point is on it
+                    const double distance = std::sqrt(distance2);
+                    glm::dvec3 normal = distance > 1e-9 * thickness ? L / distance : glm::cross(b - a, c - a);
+                    if (distance <= 1e-9 * thickness) {
+                        const double length = glm::length(normal);
+                        normal = length > 0.0 ? normal / length : glm::dvec3(0.0, 1.0, 0.0);
+                    }
+
+                    f(t, normal, thickness - distance, weights);
+                    contacts++;
+                }
+            }
+        }
+    }
+    return contacts;
+}
+
+/**
+ * calls f(s, t, normal, depth, weights) for every surface point s closer than the thickness to a triangle t
+ * that is not a lattice neighbor of it, in parallel over the surface points (all contacts of a point are found
+ * by the same thread)
+ * @param Cube* cube - cube with the self collision thickness
+ * @param const ParticleStore <Real>& p - the cube's particles
+ * @param const F& f - contact callback
+ * @return int - surface points with at least one contact
+ */
+template <typename Real>
+template <typename F>
+int SelfCollider<Real>::forEachContact(Cube* cube, const ParticleStore <Real>& p, const F& f) const {
+    const double spacing = 1.0 / double(std::max(1, cube->resolution - 1));
+    const double thickness = double(cube->selfCollisionThickness) * spacing;
+    // corners closer than this at rest are lattice neighbors of the point
+    const double neighborhood2 = (1.8 * spacing) * (1.8 * spacing);
+
+    int contacts = 0;
+    #pragma omp parallel for schedule(dynamic, 64) reduction(+:contacts)
+    for (int s = 0; s < this->surfaceCount; s++) {
+        const int i = this->surface[s];
+        const glm::dvec3 rest = glm::dvec3(p.getInitialPosition(i));
+        const auto neighbor = [&](const int* corner) {
+            return glm::distance2(rest, glm::dvec3(p.getInitialPosition(corner[0]))) < neighborhood2
+                || glm::distance2(rest, glm::dvec3(p.getInitialPosition(corner[1]))) < neighborhood2
+                || glm::distance2(rest, glm::dvec3(p.getInitialPosition(corner[2]))) < neighborhood2;
+        };
+        const auto contact = [&](int t, const glm::dvec3& normal, double depth, const glm::dvec3& weights) {
+            f(s, t, normal, depth, weights);
+        };
+        contacts += this->forEachNearTriangle(p, glm::dvec3(p.getPosition(i)), thickness, 0.0, neighbor, contact) > 0 ? 1 : 0;
+    }
+    return contacts;
+}
+
+/**
+ * triangles closer than the thickness to a point that is not part of this cube (hash built by update),
+ * or that the point is behind by less than inside; those push it out along the normal of the triangle
+ * @param const ParticleStore <Real>& p - the cube's particles
+ * @param const glm::dvec3& x - query point
+ * @param double thickness - contact distance
+ * @param double inside - depth under the surface that still counts as a contact,
+ *                        thickness + inside is at most the thickness of the last update
+ * @param TriangleContact* contacts - receives the first capacity contacts
+ * @param int capacity - size of contacts
+ * @return int - number of contacts stored
+ */
+template <typename Real>
+int SelfCollider<Real>::findTriangles(const ParticleStore <Real>& p, const glm::dvec3& x, double thickness, double inside,
+    TriangleContact* contacts, int capacity) const {
+    int count = 0;
+    if (this->triangleCount == 0) {
+        return 0;
+    }
+    this->forEachNearTriangle(p, x, thickness, inside, [](const int*) { return false; },
+        [&](int t, const glm::dvec3& normal, double depth, const glm::dvec3& weights) {
+            if (count < capacity) {
+                contacts[count++] = { t, normal, depth, weights };
+            }
+        });
+    return count;
+}
+
+/**
+ * lists the surface of the current topology if needed and rebuilds the hash for the current positions
+ * @param Cube* cube - cube with the faces
+ * @param const ParticleStore <Real>& p - the cube's particles
+ * @param double thickness - largest contact distance the queries will use
+ */
+template <typename Real>
+void SelfCollider<Real>::update(Cube* cube, const ParticleStore <Real>& p, double thickness) {
+    this->prepare(cube, p);
+    if (this->triangleCount > 0) {
+        this->build(p, thickness);
+    }
+}
+
+/**
+ * adds the self collision response to the accumulated acceleration of the surface points, and its reaction
+ * to the corners of the triangles they touch
+ * the query runs in parallel over the surface points and only records the contacts of its own point,
+ * a second pass applies them (corners are shared, so it runs in order)
+ * @param Cube* cube - cube with stiffness, damping, mass and thickness
+ * @param ParticleStore <Real>& p - particle state to read and accumulate into
+ */
+template <typename Real>
+void SelfCollider<Real>::addContactAcceleration(Cube* cube, ParticleStore <Real>& p) {
+    const double spacing = 1.0 / double(std::max(1, cube->resolution - 1));
+    this->update(cube, p, double(cube->selfCollisionThickness) * spacing);
+    int contacts = 0;
+    if (this->triangleCount > 0) {
+
+        const double stiffness = double(cube->stiffness) / double(cube->mass);
+        const double damping = double(cube->damping) * 50.0 / double(cube->mass);
+
+        std::fill(this->contactCounts, this->contactCounts + this->surfaceCount, 0);
+        contacts = this->forEachContact(cube, p, [&](int s, int t, const glm::dvec3& normal, double depth, const glm::dvec3& weights) {
+            if (this->contactCounts[s] == CONTACT_SLOTS) {
+                return;
+            }
+            const int i = this->surface[s];
+            const int* corner = this->triangles + 3 * size_t(t);
+            const glm::dvec3 closestVelocity = weights.x * glm::dvec3(p.getVelocity(corner[0]))
+                + weights.y * glm::dvec3(p.getVelocity(corner[1])) + weights.z * glm::dvec3(p.getVelocity(corner[2]));
+            const double approach = glm::dot(glm::dvec3(p.getVelocity(i)) - closestVelocity, normal);
+            const glm::dvec3 acceleration = (stiffness * depth - damping * approach) * normal;
+
+            Contact& contact = this->contactSlots[size_t(CONTACT_SLOTS) * s + this->contactCounts[s]++];
+            contact.triangle = t;
+            for (int c = 0; c < 3; c++) {
+                contact.weights[c] = Real(weights[c]);
+                contact.acceleration[c] = Real(acceleration[c]);
+            }
+        });
+
+        // every point of the cube has the same mass, the corners take the opposite acceleration by their weights
+        for (int s = 0; s < this->surfaceCount; s++) {
+            for (int k = 0; k < this->contactCounts[s]; k++) {
+                const Contact& contact = this->contactSlots[size_t(CONTACT_SLOTS) * s + k];
+                const glm::vec<3, Real> acceleration = glm::vec<3, Real>(contact.acceleration[0], contact.acceleration[1], contact.acceleration[2]);
+                p.addAcceleration(this->surface[s], acceleration);
+                const int* corner = this->triangles + 3 * size_t(contact.triangle);
+                for (int c = 0; c < 3; c++) {
+                    p.addAcceleration(corner[c], -contact.weights[c] * acceleration);
+                }
+            }
+        }
+    }
+    cube->selfCollisionStats = { this->surfaceCount, this->triangleCount, contacts, this->cellSize };
+}
+
+/**
+ * moves every free surface point out of the triangles it is too close to, by the deepest of its contacts
+ * (corrections are gathered first, so the result does not depend on the order of the points)
+ * @param Cube* cube - cube with the thickness
+ * @param ParticleStore <Real>& p - particle positions to correct
+ */
+template <typename Real>
+void SelfCollider<Real>::project(Cube* cube, ParticleStore <Real>& p) {
+    const double spacing = 1.0 / double(std::max(1, cube->resolution - 1));
+    this->update(cube, p, double(cube->selfCollisionThickness) * spacing);
+    int contacts = 0;
+    if (this->triangleCount > 0) {
+
+        contacts = this->forEachContact(cube, p, [&](int s, int, const glm::dvec3& normal, double depth, const glm::dvec3&) {
+            const glm::dvec3 current = glm::dvec3(this->correctionX[s], this->correctionY[s], this->correctionZ[s]);
+            if (depth * depth > glm::dot(current, current)) {
+                this->correctionX[s] = Real(depth * normal.x);
+                this->correctionY[s] = Real(depth * normal.y);
+                this->correctionZ[s] = Real(depth * normal.z);
+            }
+        });
+
+        #pragma omp parallel for
+        for (int s = 0; s < this->surfaceCount; s++) {
+            const int i = this->surface[s];
+            if (!p.isFixed(i)) {
+                p.px[i] += this->correctionX[s];
+                p.py[i] += this->correctionY[s];
+                p.pz[i] += this->correctionZ[s];
+            }
+            this->correctionX[s] = this->correctionY[s] = this->correctionZ[s] = Real(0);
+        }
+    }
+    cube->selfCollisionStats = { this->surfaceCount, this->triangleCount, contacts, this->cellSize };
+}
+
+template class SelfCollider <float>;
+template class SelfCollider <double>;
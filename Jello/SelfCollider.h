@@ -0,0 +1,111 @@
+#ifndef __SELFCOLLIDER_H__
+#define __SELFCOLLIDER_H__
+
+#include <glm/glm.hpp>
+
+#include "Arena.h"
+#include "ParticleStore.h"
+
+class Cube;
+
+// what the last self collision query found, shown in the ui
+struct SelfCollisionStats {
+    int surfacePoints = 0;
+    int triangles = 0;
+    // surface points closer than the thickness to a triangle of the cube
+    int contacts = 0;
+    double cellSize = 0.0;
+};
+
+// triangle of a cube closer than the contact distance to a point (or that the point is just behind), and the closest point on it
+struct TriangleContact {
+    int triangle;
+    glm::dvec3 normal;
+    double depth;
+    // barycentric weights of the closest point
+    glm::dvec3 weights;
+};
+
+// self collision of a cube: surface points against the surface triangles (two per quad of every face, wound to face out of the cube at rest)
+// the triangles are hashed by their centroid into a uniform spatial hash that is rebuilt every query,
+// the cell is as large as the biggest triangle plus the thickness, so a point only has to look at the 27 cells
+// around it; the hash is sorted with a counting sort over blocks of triangles (one count row per block,
+// prefix sum per cell over the rows, then every block scatters its triangles), stable and independent of threads
+// points that are lattice neighbors of a triangle at rest (within one cell of one of its corners) never collide
+// with it, those are held apart by the springs
+// a query runs in time linear in the surface
+// Real is the precision of the particles it reads
+template <typename Real>
+class SelfCollider {
+
+    public:
+        SelfCollider() {}; // default constructor
+
+        // contacts kept per surface point for the reaction on the triangles, a point closer to more triangles
+        // than this only collides with the first ones
+        static const int CONTACT_SLOTS = 8;
+
+        // penalty response: a spring with the thickness as rest length from the closest point of the triangle,
+        // damped along the normal against the velocity of that point (same constants as the wall contacts),
+        // the corners of the triangle take the opposite force by their weights so the cube keeps its momentum
+        void addContactAcceleration(Cube* cube, ParticleStore <Real>& p);
+        // projection response for the position based solvers: free points move out to the thickness
+        void project(Cube* cube, ParticleStore <Real>& p);
+        void clear();
+
+        // queries from outside the cube (other cubes of a world): update the hash once, then look up points
+        void update(Cube* cube, const ParticleStore <Real>& p, double thickness);
+        int findTriangles(const ParticleStore <Real>& p, const glm::dvec3& x, double thickness, double inside,
+            TriangleContact* contacts, int capacity) const;
+        int getSurfaceCount() const { return this->surfaceCount; }
+        const int* getSurface() const { return this->surface; }
+        const int* getTriangle(int t) const { return this->triangles + 3 * size_t(t); }
+
+    private:
+        // every buffer below
+        ParticleBuffers buffers{};
+        int blocks = 0;
+
+        // surface points (particle indices)
+        int* surface = nullptr;
+        int surfaceCount = 0;
+        // corners of every surface triangle (particle indices), 3 per triangle
+        int* triangles = nullptr;
+        int triangleCount = 0;
+
+        // spatial hash: bucket of every triangle, triangles sorted by bucket, first sorted entry of every bucket
+        int tableSize = 0;
+        int* bucket = nullptr;
+        int* sorted = nullptr;
+        int* bucketStart = nullptr;
+        // count rows (blocks x tableSize), then the next free slot of every block in every bucket
+        int* counts = nullptr;
+        // largest distance from a centroid to its corners, per block
+        double* blockRadius = nullptr;
+        // centroid of every triangle
+        Real *centroidX = nullptr, *centroidY = nullptr, *centroidZ = nullptr;
+        double cellSize = 1.0;
+        double radius = 0.0;
+
+        // position correction of every surface point (projection)
+        Real *correctionX = nullptr, *correctionY = nullptr, *correctionZ = nullptr;
+
+        // contacts of every surface point (CONTACT_SLOTS each), applied to the point and the triangle after the query
+        struct Contact {
+            int triangle;
+            Real weights[3];
+            Real acceleration[3];
+        };
+        Contact* contactSlots = nullptr;
+        int* contactCounts = nullptr;
+
+        void prepare(Cube* cube, const ParticleStore <Real>& p);
+        void build(const ParticleStore <Real>& p, double thickness);
+        int hash(const glm::ivec3& cell) const;
+        template <typename S, typename F>
+        int forEachNearTriangle(const ParticleStore <Real>& p, const glm::dvec3& x, double thickness, double inside, const S& skip, const F& f) const;
+        template <typename F>
+        int forEachContact(Cube* cube, const ParticleStore <Real>& p, const F& f) const;
+};
+
+#endif
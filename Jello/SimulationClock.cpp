@@ -0,0 +1,53 @@
+#include "SimulationClock.h"
+
+#include <algorithm>
+
+// starts over at the next frame, the accumulated time is dropped
+void SimulationClock::reset() {
+    this->lastWallTime = -1.0;
+    this->accumulator = 0.0;
+    this->steps = 0;
+    this->droppedTime = 0.0;
+}
+
+/**
+ * adds the wall time since the last frame to the accumulator and takes the whole steps out of it
+ * @param double wallTime - current wall clock time (s)
+ * @param double timeStep - fixed simulation step (s)
+ * @return int - steps to run this frame, at most maxSubsteps
+ */
+int SimulationClock::advance(double wallTime, double timeStep) {
+    // first frame runs one step
+    if (this->lastWallTime < 0.0) {
+        this->lastWallTime = wallTime - timeStep;
+    }
+
+    this->accumulator += std::max(0.0, wallTime - this->lastWallTime);
+    this->lastWallTime = wallTime;
+
+    // a step that is only short by rounding still runs
+    this->steps = int(this->accumulator / timeStep + 1e-6);
+    const int cap = std::max(1, this->maxSubsteps);
+    if (this->steps > cap) {
+        // drop whole steps, keep the fraction so the blend stays continuous
+        this->droppedTime += double(this->steps - cap) * timeStep;
+        this->accumulator -= double(this->steps - cap) * timeStep;
+        this->steps = cap;
+    }
+    this->accumulator -= double(this->steps) * timeStep;
+
+    return this->steps;
+}
+
+/**
+ * fraction of a step the accumulator holds, where the rendered state lies between the previous step (0)
+ * and the current one (1), the render lags behind the simulation by up to one step
+ * @param double timeStep - fixed simulation step (s)
+ * @return double - blend in [0, 1], 1 when interpolation is off
+ */
+double SimulationClock::getBlend(double timeStep) const {
+    if (!this->interpolate) {
+        return 1.0;
+    }
+    return std::min(std::max(this->accumulator / timeStep, 0.0), 1.0);
+}
@@ -0,0 +1,34 @@
+#ifndef __SIMULATIONCLOCK_H__
+#define __SIMULATIONCLOCK_H__
+
+// fixed time step clock, decouples the simulation from the frame rate
+// wall time of every frame goes into an accumulator that is spent in steps of the fixed time step,
+// so simulated time per wall second is the same at 60 Hz and 240 Hz
+// the time left in the accumulator (less than one step) blends the rendered state between the last two steps
+class SimulationClock {
+
+    public:
+        SimulationClock() {}; // default constructor
+
+        // at most this many steps per frame, a slower frame drops the rest of its time
+        // (the simulation runs in slow motion instead of falling further behind every frame)
+        int maxSubsteps = 8;
+        // render between the previous and the current step instead of the current step
+        bool interpolate = true;
+
+        int advance(double wallTime, double timeStep);
+        double getBlend(double timeStep) const;
+        void reset();
+
+        // steps run in the last frame and wall time dropped by the cap since the last reset (s)
+        int getSteps() const { return this->steps; }
+        double getDroppedTime() const { return this->droppedTime; }
+
+    private:
+        double lastWallTime = -1.0;
+        double accumulator = 0.0;
+        int steps = 0;
+        double droppedTime = 0.0;
+};
+
+#endif
@@ -0,0 +1,177 @@
+#include "SparseCholesky.h"
+
+#include <cmath>
+#include <iostream>
+
+// drops the factor
+void SparseCholesky::clear() {
+    this->n = 0;
+    this->columnStart.clear();
+    this->rowIndex.clear();
+    this->values.clear();
+}
+
+/**
+ * nonzero pattern of row k of L: every column i < k reached by climbing the elimination tree
+ * from the nonzeros A(i, k), returned in topological order (a column comes after the ones it depends on)
+ * @param const std::vector <int>& matrixStart - column starts of the upper triangle of A
+ * @param const std::vector <int>& matrixRow - row indices of the upper triangle of A
+ * @param int k - row of L
+ * @param const std::vector <int>& parent - elimination tree
+ * @param std::vector <int>& stack - size n, pattern is written to stack[top .. n - 1]
+ * @param std::vector <int>& mark - size n, all 0 on entry and on return
+ * @return int - top, start of the pattern in the stack
+ */
+int SparseCholesky::reach(const std::vector <int>& matrixStart, const std::vector <int>& matrixRow, int k, const std::vector <int>& parent,
+    std::vector <int>& stack, std::vector <int>& mark) const {
+    int top = this->n;
+    mark[k] = 1;
+
+    for (int p = matrixStart[k]; p < matrixStart[k + 1]; p++) {
+        int i = matrixRow[p];
+        if (i > k) {
+            continue;
+        }
+        // climb until a marked column, the path is pushed in reverse
+        int length = 0;
+        while (mark[i] == 0) {
+            stack[length++] = i;
+            mark[i] = 1;
+            i = parent[i];
+        }
+        while (length > 0) {
+            stack[--top] = stack[--length];
+        }
+    }
+
+    for (int p = top; p < this->n; p++) {
+        mark[stack[p]] = 0;
+    }
+    mark[k] = 0;
+    return top;
+}
+
+/**
+ * factors A = L * L^T
+ * @param int size - rows (and columns) of A
+ * @param const std::vector <int>& matrixStart - size + 1 column starts of the upper triangle of A
+ * @param const std::vector <int>& matrixRow - row indices, only rows <= column are read
+ * @param const std::vector <double>& matrixValue - values
+ * @return bool - false if A is not positive definite, the factor is dropped then
+ */
+bool SparseCholesky::factor(int size, const std::vector <int>& matrixStart, const std::vector <int>& matrixRow, const std::vector <double>& matrixValue) {
+    this->n = size;
+
+    // elimination tree, ancestor compresses the paths while it is built
+    std::vector <int> parent(size, -1);
+    std::vector <int> ancestor(size, -1);
+    for (int k = 0; k < size; k++) {
+        for (int p = matrixStart[k]; p < matrixStart[k + 1]; p++) {
+            int i = matrixRow[p];
+            while (i != -1 && i < k) {
+                const int next = ancestor[i];
+                ancestor[i] = k;
+                if (next == -1) {
+                    parent[i] = k;
+                }
+                i = next;
+            }
+        }
+    }
+
+    // symbolic: entries per column of L (the diagonal and every row k that reaches it)
+    std::vector <int> stack(size);
+    std::vector <int> mark(size, 0);
+    std::vector <int> next(size + 1, 0);
+    for (int k = 0; k < size; k++) {
+        const int top = this->reach(matrixStart, matrixRow, k, parent, stack, mark);
+        for (int p = top; p < size; p++) {
+            next[stack[p] + 1]++;
+        }
+        next[k + 1]++;
+    }
+    for (int k = 0; k < size; k++) {
+        next[k + 1] += next[k];
+    }
+    this->columnStart = next;
+    this->rowIndex.assign(next[size], 0);
+    this->values.assign(next[size], 0.0);
+
+    // numeric, row by row, next[i] is the next free entry of column i
+    std::vector <double> x(size, 0.0);
+    for (int k = 0; k < size; k++) {
+        const int top = this->reach(matrixStart, matrixRow, k, parent, stack, mark);
+
+        // x = A(0 .. k, k)
+        for (int p = matrixStart[k]; p < matrixStart[k + 1]; p++) {
+            if (matrixRow[p] <= k) {
+                x[matrixRow[p]] += matrixValue[p];
+            }
+        }
+        double diagonal = x[k];
+        x[k] = 0.0;
+
+        // solve L(0 .. k - 1, 0 .. k - 1) * l = x for row k of L
+        for (int t = top; t < size; t++) {
+            const int i = stack[t];
+            const double lki = x[i] / this->values[this->columnStart[i]];
+            x[i] = 0.0;
+            for (int p = this->columnStart[i] + 1; p < next[i]; p++) {
+                x[this->rowIndex[p]] -= this->values[p] * lki;
+            }
+            diagonal -= lki * lki;
+
+            const int p = next[i]++;
+            this->rowIndex[p] = k;
+            this->values[p] = lki;
+        }
+
+        if (diagonal <= 0.0) {
+            std::cout << "ERROR::SPARSE_CHOLESKY:: matrix is not positive definite" << std::endl;
+            this->clear();
+            return false;
+        }
+        const int p = next[k]++;
+        this->rowIndex[p] = k;
+        this->values[p] = std::sqrt(diagonal);
+    }
+
+    return true;
+}
+
+/**
+ * solves A * x = b in place with the factor, L * y = b then L^T * x = y
+ * several right hand sides are interleaved (x[j * count + c]) so the factor is read once for all of them
+ * @param double* x - b on entry, x on return (size * count entries)
+ * @param int count - right hand sides
+ */
+void SparseCholesky::solve(double* x, int count) const {
+    for (int j = 0; j < this->n; j++) {
+        const double diagonal = this->values[this->columnStart[j]];
+        double* xj = x + size_t(j) * count;
+        for (int c = 0; c < count; c++) {
+            xj[c] /= diagonal;
+        }
+        for (int p = this->columnStart[j] + 1; p < this->columnStart[j + 1]; p++) {
+            double* xi = x + size_t(this->rowIndex[p]) * count;
+            const double l = this->values[p];
+            for (int c = 0; c < count; c++) {
+                xi[c] -= l * xj[c];
+            }
+        }
+    }
+    for (int j = this->n - 1; j >= 0; j--) {
+        double* xj = x + size_t(j) * count;
+        for (int p = this->columnStart[j] + 1; p < this->columnStart[j + 1]; p++) {
+            const double* xi = x + size_t(this->rowIndex[p]) * count;
+            const double l = this->values[p];
+            for (int c = 0; c < count; c++) {
+                xj[c] -= l * xi[c];
+            }
+        }
+        const double diagonal = this->values[this->columnStart[j]];
+        for (int c = 0; c < count; c++) {
+            xj[c] /= diagonal;
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef __SPARSECHOLESKY_H__
+#define __SPARSECHOLESKY_H__
+
+#include <vector>
+#include <cstddef>
+
+// sparse Cholesky factor A = L * L^T of a symmetric positive definite matrix
+// the matrix comes in already permuted (fill reducing order is up to the caller), as its upper triangle
+// in compressed sparse columns (row indices of column j are <= j)
+// up-looking factorization: row k of L is found by walking the elimination tree from the nonzeros of column k,
+// a symbolic pass counts the entries of every column so the numeric pass fills L in place
+class SparseCholesky {
+
+    public:
+        SparseCholesky() {}; // default constructor
+
+        bool factor(int size, const std::vector <int>& columnStart, const std::vector <int>& rowIndex, const std::vector <double>& value);
+        void solve(double* x, int count = 1) const;
+        void clear();
+
+        int size() const { return this->n; }
+        size_t nonZeros() const { return this->values.size(); }
+
+    private:
+        int n = 0;
+        // L in compressed sparse columns, the diagonal is the first entry of its column
+        std::vector <int> columnStart{};
+        std::vector <int> rowIndex{};
+        std::vector <double> values{};
+
+        int reach(const std::vector <int>& matrixStart, const std::vector <int>& matrixRow, int k, const std::vector <int>& parent,
+            std::vector <int>& stack, std::vector <int>& mark) const;
+};
+
+#endif
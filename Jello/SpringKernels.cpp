@@ -0,0 +1,424 @@
+#include "SpringKernels.h"
+
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// msvc compiles intrinsics for any instruction set, gcc/clang need the target per function
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+// CPU DETECTION
+
+static void cpuid(int info[4], int leaf, int subleaf) {
+#if defined(_MSC_VER)
+    __cpuidex(info, leaf, subleaf);
+#else
+    unsigned int a, b, c, d;
+    __cpuid_count(leaf, subleaf, a, b, c, d);
+    info[0] = int(a); info[1] = int(b); info[2] = int(c); info[3] = int(d);
+#endif
+}
+
+static unsigned long long xgetbv(unsigned int index) {
+#if defined(_MSC_VER)
+    return _xgetbv(index);
+#else
+    unsigned int eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+/**
+ * checks which vector instructions the cpu and the os (saved registers) support
+ * @return simdLevelEnum - highest supported level
+ */
+static simdLevelEnum querySimdLevel() {
+    int info[4];
+    cpuid(info, 0, 0);
+    const int maxLeaf = info[0];
+    if (maxLeaf < 7) {
+        return SIMD_SCALAR;
+    }
+
+    cpuid(info, 1, 0);
+    const bool osxsave = (info[2] >> 27) & 1;
+    const bool avx = (info[2] >> 28) & 1;
+    const bool fma = (info[2] >> 12) & 1;
+    if (!osxsave || !avx || !fma) {
+        return SIMD_SCALAR;
+    }
+
+    // os has to save the ymm (and zmm) registers on context switch
+    const unsigned long long xcr0 = xgetbv(0);
+    const bool ymmState = (xcr0 & 0x6) == 0x6;
+    const bool zmmState = (xcr0 & 0xE6) == 0xE6;
+
+    cpuid(info, 7, 0);
+    const bool avx2 = (info[1] >> 5) & 1;
+    const bool avx512f = (info[1] >> 16) & 1;
+
+    if (avx512f && avx2 && zmmState) {
+        return SIMD_AVX512;
+    }
+    if (avx2 && ymmState) {
+        return SIMD_AVX2;
+    }
+    return SIMD_SCALAR;
+}
+
+simdLevelEnum detectSimdLevel() {
+    static const simdLevelEnum level = querySimdLevel();
+    return level;
+}
+
+const char* getSimdLevelName(simdLevelEnum level) {
+    switch (level) {
+    case SIMD_AVX512:
+        return "AVX-512";
+    case SIMD_AVX2:
+        return "AVX2";
+    default:
+        return "Scalar";
+    }
+}
+
+template <typename Real>
+springKernel <Real> getSpringKernel(simdLevelEnum level) {
+    const simdLevelEnum supported = detectSimdLevel();
+    if (level > supported) {
+        level = supported;
+    }
+
+    switch (level) {
+    case SIMD_AVX512:
+        return accumulateSpringsAVX512;
+    case SIMD_AVX2:
+        return accumulateSpringsAVX2;
+    default:
+        return accumulateSpringsScalar <Real>;
+    }
+}
+
+template springKernel <float> getSpringKernel <float>(simdLevelEnum level);
+template springKernel <double> getSpringKernel <double>(simdLevelEnum level);
+
+// KERNELS
+// F = (-kh * (|L| - R) - kd * ((Va - Vb) dot L) / |L|) * L / |L|
+// L = A - B, force is added to A and subtracted from B
+
+/**
+ * one spring at a time
+ * @param const SpringTable& springs - spring table, [first, last) must be inside one color
+ * @param int first, int last - range of springs
+ * @param const Real* kh - stiffness per spring type
+ * @param Real kd - damping
+ * @param Real invMass - 1 / mass
+ * @param ParticleStore <Real>& particles - particle state to read and accumulate into
+ */
+template <typename Real>
+void accumulateSpringsScalar(const SpringTable& springs, int first, int last, const Real* kh, Real kd, Real invMass, ParticleStore <Real>& particles) {
+    const int* pointA = springs.pointA;
+    const int* pointB = springs.pointB;
+    const Real* restLength = springs.getRestLength<Real>();
+    const uint8_t* type = springs.type;
+
+    const Real* px = particles.px; const Real* py = particles.py; const Real* pz = particles.pz;
+    const Real* vx = particles.vx; const Real* vy = particles.vy; const Real* vz = particles.vz;
+    Real* ax = particles.ax; Real* ay = particles.ay; Real* az = particles.az;
+
+    for (int s = first; s < last; s++) {
+        const int a = pointA[s];
+        const int b = pointB[s];
+
+        const Real lx = px[a] - px[b];
+        const Real ly = py[a] - py[b];
+        const Real lz = pz[a] - pz[b];
+        const Real length2 = lx * lx + ly * ly + lz * lz;
+        const Real invLength = Real(1) / std::sqrt(length2);
+        const Real length = length2 * invLength;
+
+        const Real dvDotL = (vx[a] - vx[b]) * lx + (vy[a] - vy[b]) * ly + (vz[a] - vz[b]) * lz;
+
+        // spring and damping share the direction L / |L|
+        const Real scale = (-kh[type[s]] * (length - restLength[s]) - kd * dvDotL * invLength) * invLength * invMass;
+
+        ax[a] += scale * lx; ay[a] += scale * ly; az[a] += scale * lz;
+        ax[b] -= scale * lx; ay[b] -= scale * ly; az[b] -= scale * lz;
+    }
+}
+
+template void accumulateSpringsScalar <float>(const SpringTable&, int, int, const float*, float, float, ParticleStore <float>&);
+template void accumulateSpringsScalar <double>(const SpringTable&, int, int, const double*, double, double, ParticleStore <double>&);
+
+/**
+ * 4 springs per iteration in double precision, remainder goes through the scalar kernel
+ * no scatter instruction in AVX2 so results are written back per lane
+ */
+TARGET_AVX2
+void accumulateSpringsAVX2(const SpringTable& springs, int first, int last, const double* kh, double kd, double invMass, ParticleStore <double>& particles) {
+    const int* pointA = springs.pointA;
+    const int* pointB = springs.pointB;
+    const double* restLength = springs.restLength;
+    const uint8_t* type = springs.type;
+
+    const double* px = particles.px; const double* py = particles.py; const double* pz = particles.pz;
+    const double* vx = particles.vx; const double* vy = particles.vy; const double* vz = particles.vz;
+    double* ax = particles.ax; double* ay = particles.ay; double* az = particles.az;
+
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d vkd = _mm256_set1_pd(kd);
+    const __m256d vInvMass = _mm256_set1_pd(invMass);
+
+    alignas(32) double fx[4];
+    alignas(32) double fy[4];
+    alignas(32) double fz[4];
+
+    int s = first;
+    for (; s + 4 <= last; s += 4) {
+        const __m128i ia = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pointA + s));
+        const __m128i ib = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pointB + s));
+        int types;
+        std::memcpy(&types, type + s, sizeof(int));
+        const __m128i it = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(types));
+
+        const __m256d lx = _mm256_sub_pd(_mm256_i32gather_pd(px, ia, 8), _mm256_i32gather_pd(px, ib, 8));
+        const __m256d ly = _mm256_sub_pd(_mm256_i32gather_pd(py, ia, 8), _mm256_i32gather_pd(py, ib, 8));
+        const __m256d lz = _mm256_sub_pd(_mm256_i32gather_pd(pz, ia, 8), _mm256_i32gather_pd(pz, ib, 8));
+        const __m256d length2 = _mm256_fmadd_pd(lx, lx, _mm256_fmadd_pd(ly, ly, _mm256_mul_pd(lz, lz)));
+        const __m256d invLength = _mm256_div_pd(one, _mm256_sqrt_pd(length2));
+        const __m256d length = _mm256_mul_pd(length2, invLength);
+
+        const __m256d dvx = _mm256_sub_pd(_mm256_i32gather_pd(vx, ia, 8), _mm256_i32gather_pd(vx, ib, 8));
+        const __m256d dvy = _mm256_sub_pd(_mm256_i32gather_pd(vy, ia, 8), _mm256_i32gather_pd(vy, ib, 8));
+        const __m256d dvz = _mm256_sub_pd(_mm256_i32gather_pd(vz, ia, 8), _mm256_i32gather_pd(vz, ib, 8));
+        const __m256d dvDotL = _mm256_fmadd_pd(dvx, lx, _mm256_fmadd_pd(dvy, ly, _mm256_mul_pd(dvz, lz)));
+
+        const __m256d vkh = _mm256_i32gather_pd(kh, it, 8);
+        const __m256d stretch = _mm256_sub_pd(length, _mm256_loadu_pd(restLength + s));
+
+        // -kh * stretch - kd * dvDotL / |L|, then * 1 / |L| * 1 / m
+        __m256d scale = _mm256_fnmsub_pd(vkh, stretch, _mm256_mul_pd(vkd, _mm256_mul_pd(dvDotL, invLength)));
+        scale = _mm256_mul_pd(scale, _mm256_mul_pd(invLength, vInvMass));
+
+        _mm256_store_pd(fx, _mm256_mul_pd(scale, lx));
+        _mm256_store_pd(fy, _mm256_mul_pd(scale, ly));
+        _mm256_store_pd(fz, _mm256_mul_pd(scale, lz));
+
+        for (int n = 0; n < 4; n++) {
+            const int a = pointA[s + n];
+            const int b = pointB[s + n];
+            ax[a] += fx[n]; ay[a] += fy[n]; az[a] += fz[n];
+            ax[b] -= fx[n]; ay[b] -= fy[n]; az[b] -= fz[n];
+        }
+    }
+
+    accumulateSpringsScalar <double>(springs, s, last, kh, kd, invMass, particles);
+}
+
+/**
+ * 8 springs per iteration in double precision, remainder goes through the scalar kernel
+ * rsqrt14 refined with two newton steps, results are scattered (points in one color are unique)
+ */
+TARGET_AVX512
+void accumulateSpringsAVX512(const SpringTable& springs, int first, int last, const double* kh, double kd, double invMass, ParticleStore <double>& particles) {
+    const int* pointA = springs.pointA;
+    const int* pointB = springs.pointB;
+    const double* restLength = springs.restLength;
+    const uint8_t* type = springs.type;
+
+    const double* px = particles.px; const double* py = particles.py; const double* pz = particles.pz;
+    const double* vx = particles.vx; const double* vy = particles.vy; const double* vz = particles.vz;
+    double* ax = particles.ax; double* ay = particles.ay; double* az = particles.az;
+
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d threeHalves = _mm512_set1_pd(1.5);
+    const __m512d vkd = _mm512_set1_pd(kd);
+    const __m512d vInvMass = _mm512_set1_pd(invMass);
+
+    int s = first;
+    for (; s + 8 <= last; s += 8) {
+        const __m256i ia = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pointA + s));
+        const __m256i ib = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pointB + s));
+        const __m256i it = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(type + s)));
+
+        const __m512d lx = _mm512_sub_pd(_mm512_i32gather_pd(ia, px, 8), _mm512_i32gather_pd(ib, px, 8));
+        const __m512d ly = _mm512_sub_pd(_mm512_i32gather_pd(ia, py, 8), _mm512_i32gather_pd(ib, py, 8));
+        const __m512d lz = _mm512_sub_pd(_mm512_i32gather_pd(ia, pz, 8), _mm512_i32gather_pd(ib, pz, 8));
+        const __m512d length2 = _mm512_fmadd_pd(lx, lx, _mm512_fmadd_pd(ly, ly, _mm512_mul_pd(lz, lz)));
+
+        // 14 bit estimate, each newton step y = y * (1.5 - 0.5 * x * y * y) doubles the precision
+        __m512d invLength = _mm512_rsqrt14_pd(length2);
+        const __m512d halfLength2 = _mm512_mul_pd(half, length2);
+        invLength = _mm512_mul_pd(invLength, _mm512_fnmadd_pd(halfLength2, _mm512_mul_pd(invLength, invLength), threeHalves));
+        invLength = _mm512_mul_pd(invLength, _mm512_fnmadd_pd(halfLength2, _mm512_mul_pd(invLength, invLength), threeHalves));
+        const __m512d length = _mm512_mul_pd(length2, invLength);
+
+        const __m512d dvx = _mm512_sub_pd(_mm512_i32gather_pd(ia, vx, 8), _mm512_i32gather_pd(ib, vx, 8));
+        const __m512d dvy = _mm512_sub_pd(_mm512_i32gather_pd(ia, vy, 8), _mm512_i32gather_pd(ib, vy, 8));
+        const __m512d dvz = _mm512_sub_pd(_mm512_i32gather_pd(ia, vz, 8), _mm512_i32gather_pd(ib, vz, 8));
+        const __m512d dvDotL = _mm512_fmadd_pd(dvx, lx, _mm512_fmadd_pd(dvy, ly, _mm512_mul_pd(dvz, lz)));
+
+        const __m512d vkh = _mm512_i32gather_pd(it, kh, 8);
+        const __m512d stretch = _mm512_sub_pd(length, _mm512_loadu_pd(restLength + s));
+
+        // -kh * stretch - kd * dvDotL / |L|, then * 1 / |L| * 1 / m
+        __m512d scale = _mm512_fnmsub_pd(vkh, stretch, _mm512_mul_pd(vkd, _mm512_mul_pd(dvDotL, invLength)));
+        scale = _mm512_mul_pd(scale, _mm512_mul_pd(invLength, vInvMass));
+
+        const __m512d fx = _mm512_mul_pd(scale, lx);
+        const __m512d fy = _mm512_mul_pd(scale, ly);
+        const __m512d fz = _mm512_mul_pd(scale, lz);
+
+        _mm512_i32scatter_pd(ax, ia, _mm512_add_pd(_mm512_i32gather_pd(ia, ax, 8), fx), 8);
+        _mm512_i32scatter_pd(ay, ia, _mm512_add_pd(_mm512_i32gather_pd(ia, ay, 8), fy), 8);
+        _mm512_i32scatter_pd(az, ia, _mm512_add_pd(_mm512_i32gather_pd(ia, az, 8), fz), 8);
+        _mm512_i32scatter_pd(ax, ib, _mm512_sub_pd(_mm512_i32gather_pd(ib, ax, 8), fx), 8);
+        _mm512_i32scatter_pd(ay, ib, _mm512_sub_pd(_mm512_i32gather_pd(ib, ay, 8), fy), 8);
+        _mm512_i32scatter_pd(az, ib, _mm512_sub_pd(_mm512_i32gather_pd(ib, az, 8), fz), 8);
+    }
+
+    accumulateSpringsScalar <double>(springs, s, last, kh, kd, invMass, particles);
+}
+
+/**
+ * 8 springs per iteration in single precision, remainder goes through the scalar kernel
+ * rsqrt (12 bit) refined with one newton step, results are written back per lane
+ */
+TARGET_AVX2
+void accumulateSpringsAVX2(const SpringTable& springs, int first, int last, const float* kh, float kd, float invMass, ParticleStore <float>& particles) {
+    const int* pointA = springs.pointA;
+    const int* pointB = springs.pointB;
+    const float* restLength = springs.restLengthFloat;
+    const uint8_t* type = springs.type;
+
+    const float* px = particles.px; const float* py = particles.py; const float* pz = particles.pz;
+    const float* vx = particles.vx; const float* vy = particles.vy; const float* vz = particles.vz;
+    float* ax = particles.ax; float* ay = particles.ay; float* az = particles.az;
+
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 threeHalves = _mm256_set1_ps(1.5f);
+    const __m256 vkd = _mm256_set1_ps(kd);
+    const __m256 vInvMass = _mm256_set1_ps(invMass);
+
+    alignas(32) float fx[8];
+    alignas(32) float fy[8];
+    alignas(32) float fz[8];
+
+    int s = first;
+    for (; s + 8 <= last; s += 8) {
+        const __m256i ia = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pointA + s));
+        const __m256i ib = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pointB + s));
+        const __m256i it = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(type + s)));
+
+        const __m256 lx = _mm256_sub_ps(_mm256_i32gather_ps(px, ia, 4), _mm256_i32gather_ps(px, ib, 4));
+        const __m256 ly = _mm256_sub_ps(_mm256_i32gather_ps(py, ia, 4), _mm256_i32gather_ps(py, ib, 4));
+        const __m256 lz = _mm256_sub_ps(_mm256_i32gather_ps(pz, ia, 4), _mm256_i32gather_ps(pz, ib, 4));
+        const __m256 length2 = _mm256_fmadd_ps(lx, lx, _mm256_fmadd_ps(ly, ly, _mm256_mul_ps(lz, lz)));
+
+        // y = y * (1.5 - 0.5 * x * y * y)
+        __m256 invLength = _mm256_rsqrt_ps(length2);
+        invLength = _mm256_mul_ps(invLength, _mm256_fnmadd_ps(_mm256_mul_ps(half, length2), _mm256_mul_ps(invLength, invLength), threeHalves));
+        const __m256 length = _mm256_mul_ps(length2, invLength);
+
+        const __m256 dvx = _mm256_sub_ps(_mm256_i32gather_ps(vx, ia, 4), _mm256_i32gather_ps(vx, ib, 4));
+        const __m256 dvy = _mm256_sub_ps(_mm256_i32gather_ps(vy, ia, 4), _mm256_i32gather_ps(vy, ib, 4));
+        const __m256 dvz = _mm256_sub_ps(_mm256_i32gather_ps(vz, ia, 4), _mm256_i32gather_ps(vz, ib, 4));
+        const __m256 dvDotL = _mm256_fmadd_ps(dvx, lx, _mm256_fmadd_ps(dvy, ly, _mm256_mul_ps(dvz, lz)));
+
+        const __m256 vkh = _mm256_i32gather_ps(kh, it, 4);
+        const __m256 stretch = _mm256_sub_ps(length, _mm256_loadu_ps(restLength + s));
+
+        // -kh * stretch - kd * dvDotL / |L|, then * 1 / |L| * 1 / m
+        __m256 scale = _mm256_fnmsub_ps(vkh, stretch, _mm256_mul_ps(vkd, _mm256_mul_ps(dvDotL, invLength)));
+        scale = _mm256_mul_ps(scale, _mm256_mul_ps(invLength, vInvMass));
+
+        _mm256_store_ps(fx, _mm256_mul_ps(scale, lx));
+        _mm256_store_ps(fy, _mm256_mul_ps(scale, ly));
+        _mm256_store_ps(fz, _mm256_mul_ps(scale, lz));
+
+        for (int n = 0; n < 8; n++) {
+            const int a = pointA[s + n];
+            const int b = pointB[s + n];
+            ax[a] += fx[n]; ay[a] += fy[n]; az[a] += fz[n];
+            ax[b] -= fx[n]; ay[b] -= fy[n]; az[b] -= fz[n];
+        }
+    }
+
+    accumulateSpringsScalar <float>(springs, s, last, kh, kd, invMass, particles);
+}
+
+/**
+ * 16 springs per iteration in single precision, remainder goes through the scalar kernel
+ * rsqrt14 refined with one newton step, results are scattered (points in one color are unique)
+ */
+TARGET_AVX512
+void accumulateSpringsAVX512(const SpringTable& springs, int first, int last, const float* kh, float kd, float invMass, ParticleStore <float>& particles) {
+    const int* pointA = springs.pointA;
+    const int* pointB = springs.pointB;
+    const float* restLength = springs.restLengthFloat;
+    const uint8_t* type = springs.type;
+
+    const float* px = particles.px; const float* py = particles.py; const float* pz = particles.pz;
+    const float* vx = particles.vx; const float* vy = particles.vy; const float* vz = particles.vz;
+    float* ax = particles.ax; float* ay = particles.ay; float* az = particles.az;
+
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 threeHalves = _mm512_set1_ps(1.5f);
+    const __m512 vkd = _mm512_set1_ps(kd);
+    const __m512 vInvMass = _mm512_set1_ps(invMass);
+
+    int s = first;
+    for (; s + 16 <= last; s += 16) {
+        const __m512i ia = _mm512_loadu_si512(pointA + s);
+        const __m512i ib = _mm512_loadu_si512(pointB + s);
+        const __m512i it = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(type + s)));
+
+        const __m512 lx = _mm512_sub_ps(_mm512_i32gather_ps(ia, px, 4), _mm512_i32gather_ps(ib, px, 4));
+        const __m512 ly = _mm512_sub_ps(_mm512_i32gather_ps(ia, py, 4), _mm512_i32gather_ps(ib, py, 4));
+        const __m512 lz = _mm512_sub_ps(_mm512_i32gather_ps(ia, pz, 4), _mm512_i32gather_ps(ib, pz, 4));
+        const __m512 length2 = _mm512_fmadd_ps(lx, lx, _mm512_fmadd_ps(ly, ly, _mm512_mul_ps(lz, lz)));
+
+        // y = y * (1.5 - 0.5 * x * y * y)
+        __m512 invLength = _mm512_rsqrt14_ps(length2);
+        invLength = _mm512_mul_ps(invLength, _mm512_fnmadd_ps(_mm512_mul_ps(half, length2), _mm512_mul_ps(invLength, invLength), threeHalves));
+        const __m512 length = _mm512_mul_ps(length2, invLength);
+
+        const __m512 dvx = _mm512_sub_ps(_mm512_i32gather_ps(ia, vx, 4), _mm512_i32gather_ps(ib, vx, 4));
+        const __m512 dvy = _mm512_sub_ps(_mm512_i32gather_ps(ia, vy, 4), _mm512_i32gather_ps(ib, vy, 4));
+        const __m512 dvz = _mm512_sub_ps(_mm512_i32gather_ps(ia, vz, 4), _mm512_i32gather_ps(ib, vz, 4));
+        const __m512 dvDotL = _mm512_fmadd_ps(dvx, lx, _mm512_fmadd_ps(dvy, ly, _mm512_mul_ps(dvz, lz)));
+
+        const __m512 vkh = _mm512_i32gather_ps(it, kh, 4);
+        const __m512 stretch = _mm512_sub_ps(length, _mm512_loadu_ps(restLength + s));
+
+        // -kh * stretch - kd * dvDotL / |L|, then * 1 / |L| * 1 / m
+        __m512 scale = _mm512_fnmsub_ps(vkh, stretch, _mm512_mul_ps(vkd, _mm512_mul_ps(dvDotL, invLength)));
+        scale = _mm512_mul_ps(scale, _mm512_mul_ps(invLength, vInvMass));
+
+        const __m512 fx = _mm512_mul_ps(scale, lx);
+        const __m512 fy = _mm512_mul_ps(scale, ly);
+        const __m512 fz = _mm512_mul_ps(scale, lz);
+
+        _mm512_i32scatter_ps(ax, ia, _mm512_add_ps(_mm512_i32gather_ps(ia, ax, 4), fx), 4);
+        _mm512_i32scatter_ps(ay, ia, _mm512_add_ps(_mm512_i32gather_ps(ia, ay, 4), fy), 4);
+        _mm512_i32scatter_ps(az, ia, _mm512_add_ps(_mm512_i32gather_ps(ia, az, 4), fz), 4);
+        _mm512_i32scatter_ps(ax, ib, _mm512_sub_ps(_mm512_i32gather_ps(ib, ax, 4), fx), 4);
+        _mm512_i32scatter_ps(ay, ib, _mm512_sub_ps(_mm512_i32gather_ps(ib, ay, 4), fy), 4);
+        _mm512_i32scatter_ps(az, ib, _mm512_sub_ps(_mm512_i32gather_ps(ib, az, 4), fz), 4);
+    }
+
+    accumulateSpringsScalar <float>(springs, s, last, kh, kd, invMass, particles);
+}
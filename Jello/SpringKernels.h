@@ -0,0 +1,33 @@
+#ifndef __SPRINGKERNELS_H__
+#define __SPRINGKERNELS_H__
+
+#include "ParticleStore.h"
+#include "SpringTable.h"
+
+// fused Hooke + damping force kernels over a range of the spring table
+// one reciprocal square root per spring, springs in the range must not share points
+// (one batch of the spring table) because the results are scattered without atomics
+
+enum simdLevelEnum {
+    SIMD_SCALAR, SIMD_AVX2, SIMD_AVX512
+}; // scalar = 0, AVX2 = 1, AVX-512 = 2
+
+// Real is the scalar of the particle store (float or double)
+template <typename Real>
+using springKernel = void (*)(const SpringTable& springs, int first, int last, const Real* kh, Real kd, Real invMass, ParticleStore <Real>& particles);
+
+// cpu support, checked once
+simdLevelEnum detectSimdLevel();
+const char* getSimdLevelName(simdLevelEnum level);
+// best kernel the cpu supports, never above the requested level
+template <typename Real>
+springKernel <Real> getSpringKernel(simdLevelEnum level);
+
+template <typename Real>
+void accumulateSpringsScalar(const SpringTable& springs, int first, int last, const Real* kh, Real kd, Real invMass, ParticleStore <Real>& particles);
+void accumulateSpringsAVX2(const SpringTable& springs, int first, int last, const double* kh, double kd, double invMass, ParticleStore <double>& particles); // 4 springs per iteration
+void accumulateSpringsAVX512(const SpringTable& springs, int first, int last, const double* kh, double kd, double invMass, ParticleStore <double>& particles); // 8 springs per iteration
+void accumulateSpringsAVX2(const SpringTable& springs, int first, int last, const float* kh, float kd, float invMass, ParticleStore <float>& particles); // 8 springs per iteration
+void accumulateSpringsAVX512(const SpringTable& springs, int first, int last, const float* kh, float kd, float invMass, ParticleStore <float>& particles); // 16 springs per iteration
+
+#endif
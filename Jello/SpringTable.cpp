@@ -0,0 +1,189 @@
+#include "SpringTable.h"
+
+#include <iostream>
+#include <algorithm>
+
+// arena bytes for a table of capacity springs
+size_t SpringTable::bytesFor(int capacity) {
+    return 2 * Arena::bytesFor<int>(capacity) + Arena::bytesFor<double>(capacity) + Arena::bytesFor<float>(capacity)
+        + Arena::bytesFor<uint8_t>(capacity);
+}
+
+// forgets the spring arrays, the arena they came from releases the memory
+void SpringTable::clear() {
+    this->count = 0;
+    this->capacity = 0;
+    this->pointA = nullptr;
+    this->pointB = nullptr;
+    this->restLength = nullptr;
+    this->restLengthFloat = nullptr;
+    this->type = nullptr;
+    this->phaseOffsets.assign(1, 0);
+    this->groupOffsets.assign(1, 0);
+    this->batchOffsets.assign(1, 0);
+}
+
+/**
+ * takes the spring arrays from the arena, the table holds at most capacity springs
+ * @param Arena& arena - arena with at least bytesFor(capacity) left
+ * @param int capacity - upper bound of springs added before the next clear
+ */
+void SpringTable::allocate(Arena& arena, int capacity) {
+    this->count = 0;
+    this->capacity = capacity;
+    this->pointA = arena.allocate<int>(capacity);
+    this->pointB = arena.allocate<int>(capacity);
+    this->restLength = arena.allocate<double>(capacity);
+    this->restLengthFloat = arena.allocate<float>(capacity);
+    this->type = arena.allocate<uint8_t>(capacity);
+}
+
+int SpringTable::addSpring(int pointA, int pointB, double restLength, springTypeEnum type) {
+    if (this->count == this->capacity) {
+        std::cout << "ERROR::SPRINGTABLE:: more springs than allocated" << std::endl;
+        return -1;
+    }
+
+    const int s = this->count++;
+    this->pointA[s] = pointA;
+    this->pointB[s] = pointB;
+    this->restLength[s] = restLength;
+    this->restLengthFloat[s] = float(restLength);
+    this->type[s] = uint8_t(type);
+
+    return s;
+}
+
+void SpringTable::permute(const std::vector <int>& order, int first) {
+    // order[n] is the spring that moves to first + n
+    const int count = int(order.size());
+    std::vector <int> sortedA(count);
+    std::vector <int> sortedB(count);
+    std::vector <double> sortedRest(count);
+    std::vector <float> sortedRestFloat(count);
+    std::vector <uint8_t> sortedType(count);
+    for (int n = 0; n < count; n++) {
+        sortedA[n] = this->pointA[order[n]];
+        sortedB[n] = this->pointB[order[n]];
+        sortedRest[n] = this->restLength[order[n]];
+        sortedRestFloat[n] = this->restLengthFloat[order[n]];
+        sortedType[n] = this->type[order[n]];
+    }
+
+    std::copy(sortedA.begin(), sortedA.end(), this->pointA + first);
+    std::copy(sortedB.begin(), sortedB.end(), this->pointB + first);
+    std::copy(sortedRest.begin(), sortedRest.end(), this->restLength + first);
+    std::copy(sortedRestFloat.begin(), sortedRestFloat.end(), this->restLengthFloat + first);
+    std::copy(sortedType.begin(), sortedType.end(), this->type + first);
+}
+
+/**
+ * two level coloring of the spring graph.
+ * Every spring belongs to the brick at the lower corner of its two end points, so a brick's springs
+ * only touch that brick and its +1 neighbors. Bricks are colored by the parity of their coordinates
+ * (8 phases), two bricks of one phase are two bricks apart along some axis and never share a point
+ * as long as a brick is at least 2 points wide (springs span at most 2 points).
+ * Inside a brick, a greedy edge coloring gives every spring the lowest color not used yet by either
+ * of its end points. Springs are reordered so phases, bricks and colors are contiguous
+ * @param const std::vector <int>& pointBrick - brick of every point, (by * n + bz) * n + bx
+ * @param int bricksPerSide - n, number of bricks along each axis
+ */
+void SpringTable::buildBatches(const std::vector <int>& pointBrick, int bricksPerSide) {
+    const int n = bricksPerSide;
+    const int brickCount = n * n * n;
+    const int springCount = this->size();
+
+    // sort springs by phase, then brick
+    std::vector <int> springKey(springCount);
+    std::vector <int> keyCount(8 * brickCount + 1, 0);
+    for (int s = 0; s < springCount; s++) {
+        const int brickA = pointBrick[this->pointA[s]];
+        const int brickB = pointBrick[this->pointB[s]];
+        const int bx = std::min(brickA % n, brickB % n);
+        const int bz = std::min((brickA / n) % n, (brickB / n) % n);
+        const int by = std::min(brickA / (n * n), brickB / (n * n));
+        const int brick = (by * n + bz) * n + bx;
+        const int phase = (bx & 1) | ((by & 1) << 1) | ((bz & 1) << 2);
+
+        springKey[s] = phase * brickCount + brick;
+        keyCount[springKey[s] + 1]++;
+    }
+    for (int key = 0; key < 8 * brickCount; key++) {
+        keyCount[key + 1] += keyCount[key];
+    }
+
+    // stable counting sort, springs keep their build order inside a brick
+    std::vector <int> order(springCount);
+    std::vector <int> next(keyCount.begin(), keyCount.end() - 1);
+    for (int s = 0; s < springCount; s++) {
+        order[next[springKey[s]]++] = s;
+    }
+    this->permute(order, 0);
+
+    // one bit per color already used by a point
+    // a lattice point has at most 32 springs, so greedy needs at most 63 colors
+    std::vector <uint64_t> usedColors(pointBrick.size(), 0);
+
+    this->phaseOffsets.assign(1, 0);
+    this->groupOffsets.assign(1, 0);
+    this->batchOffsets.assign(1, 0);
+
+    for (int phase = 0; phase < 8; phase++) {
+        for (int brick = 0; brick < brickCount; brick++) {
+            const int first = keyCount[phase * brickCount + brick];
+            const int last = keyCount[phase * brickCount + brick + 1];
+            if (first == last) {
+                continue;
+            }
+
+            // color springs of this brick
+            std::vector <int> color(last - first);
+            std::vector <int> colorSize{};
+            for (int s = first; s < last; s++) {
+                const uint64_t used = usedColors[this->pointA[s]] | usedColors[this->pointB[s]];
+
+                int c = 0;
+                while (c < 64 && ((used >> c) & 1u)) {
+                    c++;
+                }
+                if (c == 64) {
+                    std::cout << "ERROR::SPRINGTABLE:: more than 64 spring colors needed" << std::endl;
+                    c = 63;
+                }
+
+                usedColors[this->pointA[s]] |= uint64_t(1) << c;
+                usedColors[this->pointB[s]] |= uint64_t(1) << c;
+                color[s - first] = c;
+
+                if (c >= int(colorSize.size())) {
+                    colorSize.resize(c + 1, 0);
+                }
+                colorSize[c]++;
+            }
+
+            // clear the masks again for the next brick
+            for (int s = first; s < last; s++) {
+                usedColors[this->pointA[s]] = 0;
+                usedColors[this->pointB[s]] = 0;
+            }
+
+            // stable sort by color inside the brick
+            std::vector <int> colorNext(colorSize.size(), first);
+            for (int c = 1; c < int(colorSize.size()); c++) {
+                colorNext[c] = colorNext[c - 1] + colorSize[c - 1];
+            }
+            for (int c = 0; c < int(colorSize.size()); c++) {
+                this->batchOffsets.push_back(colorNext[c] + colorSize[c]);
+            }
+            std::vector <int> brickOrder(last - first);
+            for (int s = first; s < last; s++) {
+                brickOrder[colorNext[color[s - first]]++ - first] = s;
+            }
+            this->permute(brickOrder, first);
+
+            this->groupOffsets.push_back(this->batchCount());
+        }
+
+        this->phaseOffsets.push_back(this->groupCount());
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef __SPRINGTABLE_H__
+#define __SPRINGTABLE_H__
+
+#include <vector>
+#include <cstdint>
+
+#include "Arena.h"
+
+enum springTypeEnum {
+    STRUCTURAL, SHEAR, BEND, SPRING_TYPE_COUNT
+}; // structural = 0, shear = 1, bend = 2
+
+// every spring of a cube stored once, as parallel arrays
+// built with the topology so the force pass does not recompute rest lengths
+// the spring arrays live in the cube's topology arena
+class SpringTable {
+
+    public:
+        SpringTable() {}; // default constructor
+        // copies would alias the same arena memory
+        SpringTable(const SpringTable&) = delete;
+        SpringTable& operator=(const SpringTable&) = delete;
+
+        // setup
+        static size_t bytesFor(int capacity);
+        void clear();
+        void allocate(Arena& arena, int capacity);
+        int addSpring(int pointA, int pointB, double restLength, springTypeEnum type);
+        int size() const { return this->count; }
+
+        // split springs into batches where no two springs share a point
+        void buildBatches(const std::vector <int>& pointBrick, int bricksPerSide);
+        int phaseCount() const { return int(this->phaseOffsets.size()) - 1; }
+        int groupCount() const { return int(this->groupOffsets.size()) - 1; }
+        int batchCount() const { return int(this->batchOffsets.size()) - 1; }
+        // runs f(spring) for every spring in parallel, springs that share a point never run at the same time
+        template <typename F>
+        void forEachColored(const F& f) const;
+
+        // endpoint indices into the cube's particle store
+        int* pointA = nullptr;
+        int* pointB = nullptr;
+        // distance between the endpoints at rest, and the same rounded once for the float solver
+        double* restLength = nullptr;
+        float* restLengthFloat = nullptr;
+        template <typename Real>
+        const Real* getRestLength() const;
+        // springTypeEnum of each spring
+        uint8_t* type = nullptr;
+
+        // two level coloring:
+        // a group is every spring of one brick of the lattice, groups of one phase never share a point
+        // a batch is one color inside a group, springs of one batch never share a point
+        // phase p holds groups [phaseOffsets[p], phaseOffsets[p + 1])
+        // group g holds batches [groupOffsets[g], groupOffsets[g + 1])
+        // batch b holds springs [batchOffsets[b], batchOffsets[b + 1])
+        std::vector <int> phaseOffsets{ 0 };
+        std::vector <int> groupOffsets{ 0 };
+        std::vector <int> batchOffsets{ 0 };
+
+    private:
+        int count = 0;
+        int capacity = 0;
+        void permute(const std::vector <int>& order, int first);
+};
+
+/**
+ * runs f(spring) for every spring, groups of one phase run in parallel and a group runs its springs in order
+ * (same order as the force pass), so f may write both end points of its spring without atomics
+ * @param const F& f - called with the spring index
+ */
+template <typename F>
+void SpringTable::forEachColored(const F& f) const {
+    #pragma omp parallel
+    {
+        for (int phase = 0; phase < this->phaseCount(); phase++) {
+            // implicit barrier at the end, next phase waits for this one
+            #pragma omp for schedule(dynamic)
+            for (int group = this->phaseOffsets[phase]; group < this->phaseOffsets[phase + 1]; group++) {
+                const int first = this->batchOffsets[this->groupOffsets[group]];
+                const int last = this->batchOffsets[this->groupOffsets[group + 1]];
+                for (int s = first; s < last; s++) {
+                    f(s);
+                }
+            }
+        }
+    }
+}
+
+template <>
+inline const double* SpringTable::getRestLength <double>() const { return this->restLength; }
+template <>
+inline const float* SpringTable::getRestLength <float>() const { return this->restLengthFloat; }
+
+#endif
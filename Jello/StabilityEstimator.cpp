@@ -0,0 +1,184 @@
+#include "StabilityEstimator.h"
+#include "Cube.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// wave vectors sampled per axis in [0, pi], maxima between samples are left to the safety factor
+static const int WAVE_SAMPLES = 17;
+
+/**
+ * largest eigenvalue of a symmetric 3x3 matrix (closed form, three real roots of the characteristic polynomial)
+ * @param const glm::dmat3& A - symmetric matrix
+ * @return double - largest eigenvalue
+ */
+static double largestEigenvalue(const glm::dmat3& A) {
+    const double offDiagonal = A[0][1] * A[0][1] + A[0][2] * A[0][2] + A[1][2] * A[1][2];
+    const double mean = (A[0][0] + A[1][1] + A[2][2]) / 3.0;
+    if (offDiagonal == 0.0) {
+        return std::max(A[0][0], std::max(A[1][1], A[2][2]));
+    }
+
+    const double a = A[0][0] - mean, b = A[1][1] - mean, c = A[2][2] - mean;
+    const double spread = std::sqrt((a * a + b * b + c * c + 2.0 * offDiagonal) / 6.0);
+    const glm::dmat3 B = (A - mean * glm::dmat3(1.0)) / spread;
+    const double r = std::min(1.0, std::max(-1.0, glm::determinant(B) / 2.0));
+    return mean + 2.0 * spread * std::cos(std::acos(r) / 3.0);
+}
+
+/**
+ * samples the largest eigenvalue of D(q) over the wave vectors for the cube's spring stencil
+ * @param Cube* cube - cube with the stencil and spring type multipliers
+ */
+void StabilityEstimator::bound(Cube* cube) {
+    const LatticeStencil& stencil = cube->stencil;
+
+    int typeCount[SPRING_TYPE_COUNT] = {};
+    for (int n = 0; n < stencil.size(); n++) {
+        typeCount[stencil.type[n]]++;
+    }
+    bool cached = true;
+    for (int t = 0; t < SPRING_TYPE_COUNT; t++) {
+        cached = cached && typeCount[t] == this->typeCount[t] && cube->springTypeStiffness[t] == this->typeStiffness[t];
+    }
+    if (cached) {
+        return;
+    }
+
+    // n * n^T of every offset, weighted by its type multiplier for the stiffness
+    std::vector <glm::dvec3> offset(stencil.size());
+    std::vector <glm::dmat3> direction(stencil.size());
+    for (int n = 0; n < stencil.size(); n++) {
+        offset[n] = glm::dvec3(stencil.di[n], stencil.dj[n], stencil.dk[n]);
+        const glm::dvec3 unit = glm::normalize(offset[n]);
+        direction[n] = glm::outerProduct(unit, unit);
+    }
+
+    const double pi = std::acos(-1.0);
+    double stiffnessBound = 0.0;
+    double dampingBound = 0.0;
+    for (int x = 0; x < WAVE_SAMPLES; x++) {
+        for (int y = 0; y < WAVE_SAMPLES; y++) {
+            for (int z = 0; z < WAVE_SAMPLES; z++) {
+                const glm::dvec3 q = glm::dvec3(x, y, z) * (pi / double(WAVE_SAMPLES - 1));
+                glm::dmat3 stiffness = glm::dmat3(0.0);
+                glm::dmat3 damping = glm::dmat3(0.0);
+                for (int n = 0; n < stencil.size(); n++) {
+                    const glm::dmat3 term = direction[n] * (1.0 - std::cos(glm::dot(q, offset[n])));
+                    stiffness += term * double(cube->springTypeStiffness[stencil.type[n]]);
+                    damping += term;
+                }
+                stiffnessBound = std::max(stiffnessBound, largestEigenvalue(stiffness));
+                dampingBound = std::max(dampingBound, largestEigenvalue(damping));
+            }
+        }
+    }
+
+    this->stiffnessBound = stiffnessBound;
+    this->dampingBound = dampingBound;
+    for (int t = 0; t < SPRING_TYPE_COUNT; t++) {
+        this->typeCount[t] = typeCount[t];
+        this->typeStiffness[t] = cube->springTypeStiffness[t];
+    }
+}
+
+/**
+ * highest natural frequency and damping rate of the cube at its current stiffness, damping and mass
+ * @param Cube* cube - cube to estimate
+ * @return StabilityLimit - omega and damping, the step is left to stableStep
+ */
+StabilityLimit StabilityEstimator::estimate(Cube* cube) {
+    this->bound(cube);
+
+    // wall contact: rest length 0 spring of the full stiffness, 50 times the spring damping
+    const double mass = double(cube->mass);
+    StabilityLimit limit;
+    limit.omega = std::sqrt((double(cube->stiffness) * (this->stiffnessBound + 1.0)) / mass);
+    limit.damping = double(cube->damping) * (this->dampingBound + 50.0) / mass;
+    return limit;
+}
+
+/**
+ * one step of the method on the single mode x'' = -omega^2 * x - damping * x' (same update as the integrator)
+ * @param explicitMethodEnum method - integrator
+ * @param double omega2, double damping - mode
+ * @param double h - step
+ * @param double& x, double& v - state, advanced in place
+ */
+static void stepMode(explicitMethodEnum method, double omega2, double damping, double h, double& x, double& v) {
+    if (method == EXPLICIT_SYMPLECTIC_EULER) {
+        v += h * (-omega2 * x - damping * v);
+        x += h * v;
+    }
+    else if (method == EXPLICIT_VELOCITY_VERLET) {
+        // damping of the second kick sees the half step velocity
+        v += 0.5 * h * (-omega2 * x - damping * v);
+        x += h * v;
+        v += 0.5 * h * (-omega2 * x - damping * v);
+    }
+    else {
+        const double x1 = x, v1 = v, a1 = -omega2 * x1 - damping * v1;
+        const double x2 = x + 0.5 * h * v1, v2 = v + 0.5 * h * a1, a2 = -omega2 * x2 - damping * v2;
+        const double x3 = x + 0.5 * h * v2, v3 = v + 0.5 * h * a2, a3 = -omega2 * x3 - damping * v3;
+        const double x4 = x + h * v3, v4 = v + h * a3, a4 = -omega2 * x4 - damping * v4;
+        x += h / 6.0 * (v1 + 2.0 * v2 + 2.0 * v3 + v4);
+        v += h / 6.0 * (a1 + 2.0 * a2 + 2.0 * a3 + a4);
+    }
+}
+
+/**
+ * spectral radius of one step of the method on a single mode, the step is stable while it is at most 1
+ */
+static double amplification(explicitMethodEnum method, double omega2, double damping, double h) {
+    double x0 = 1.0, v0 = 0.0, x1 = 0.0, v1 = 1.0;
+    stepMode(method, omega2, damping, h, x0, v0);
+    stepMode(method, omega2, damping, h, x1, v1);
+
+    // eigenvalues of [[x0, x1], [v0, v1]]
+    const double trace = x0 + v1;
+    const double determinant = x0 * v1 - x1 * v0;
+    const double discriminant = trace * trace / 4.0 - determinant;
+    if (discriminant < 0.0) {
+        return std::sqrt(std::fabs(determinant));
+    }
+    const double root = std::sqrt(discriminant);
+    return std::max(std::fabs(trace / 2.0 + root), std::fabs(trace / 2.0 - root));
+}
+
+/**
+ * largest step the method stays stable at for every mode up to omega and damping,
+ * bisection on the amplification of the extreme modes (stiffest with and without damping, pure damping)
+ * @param double omega - highest natural angular frequency (rad/s)
+ * @param double damping - highest damping rate (1/s)
+ * @param explicitMethodEnum method - integrator
+ * @return double - stable step (s), without safety factor
+ */
+double StabilityEstimator::stableStep(double omega, double damping, explicitMethodEnum method) {
+    const double rate = std::max(omega, damping);
+    if (rate <= 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    const double omega2 = omega * omega;
+    auto stable = [&](double h) {
+        const double tolerance = 1.0 + 1e-12;
+        return amplification(method, omega2, damping, h) <= tolerance && amplification(method, omega2, 0.0, h) <= tolerance
+            && amplification(method, 0.0, damping, h) <= tolerance;
+    };
+
+    // every method is unstable beyond 4 / rate, bisect between a stable and an unstable step
+    double low = 0.0;
+    double high = 4.0 / rate;
+    for (int i = 0; i < 50; i++) {
+        const double middle = 0.5 * (low + high);
+        if (stable(middle)) {
+            low = middle;
+        }
+        else {
+            high = middle;
+        }
+    }
+    return low;
+}
@@ -0,0 +1,49 @@
+#ifndef __STABILITYESTIMATOR_H__
+#define __STABILITYESTIMATOR_H__
+
+#include "SpringTable.h"
+
+class Cube;
+
+enum explicitMethodEnum {
+    EXPLICIT_SYMPLECTIC_EULER, EXPLICIT_VELOCITY_VERLET, EXPLICIT_RK4
+}; // symplectic euler = 0, velocity verlet = 1, RK4 = 2
+
+// bounds of the linearized spring system and the step they allow, shown in the ui
+struct StabilityLimit {
+    // highest natural angular frequency (rad/s) and highest damping rate (1/s) of any mode
+    double omega = 0.0;
+    double damping = 0.0;
+    // largest stable step of the method with the safety factor applied (s)
+    double stableStep = 0.0;
+    // substeps the last step was split into
+    int substeps = 1;
+};
+
+// upper bound of the highest natural frequency of the lattice
+// a lattice mode with wave vector q oscillates at omega^2 = eigenvalue of
+// D(q) / m = sum over the stencil of k * n * n^T * (1 - cos(q . d)) / m, the cube is a part of the infinite
+// lattice with free surfaces, which only lowers its frequencies, so the largest D(q) bounds all of its modes
+// the wall contacts add a spring of the full stiffness (and 50 times the damping) to any point
+// D(q) only depends on the spring stencil and the type multipliers, its maxima per unit stiffness and damping
+// are cached and scaled by stiffness, damping and mass on every estimate
+class StabilityEstimator {
+
+    public:
+        StabilityEstimator() {}; // default constructor
+
+        StabilityLimit estimate(Cube* cube);
+        static double stableStep(double omega, double damping, explicitMethodEnum method);
+
+    private:
+        // what the cached maxima were computed for
+        int typeCount[SPRING_TYPE_COUNT] = { -1, -1, -1 };
+        float typeStiffness[SPRING_TYPE_COUNT] = {};
+        // largest eigenvalue of D(q) per unit stiffness, and per unit damping (every spring weighted 1)
+        double stiffnessBound = 0.0;
+        double dampingBound = 0.0;
+
+        void bound(Cube* cube);
+};
+
+#endif
@@ -0,0 +1,110 @@
+#include "SweptCollider.h"
+#include "Physics.h"
+
+/**
+ * lays out the start positions for the current topology
+ * @param const ParticleStore <Real>& p - the cube's particles
+ */
+template <typename Real>
+void SweptCollider<Real>::prepare(const ParticleStore <Real>& p) {
+    const int count = p.size();
+    if (this->buffers.fits(count)) {
+        return;
+    }
+
+    Arena& arena = this->buffers.resize(count, 0, 3 * Arena::bytesFor<Real>(count));
+    this->startX = arena.allocate<Real>(count);
+    this->startY = arena.allocate<Real>(count);
+    this->startZ = arena.allocate<Real>(count);
+}
+
+/**
+ * keeps the positions at the start of a step, the start of every point's line
+ * @param const ParticleStore <Real>& p - the cube's particles
+ */
+template <typename Real>
+void SweptCollider<Real>::begin(const ParticleStore <Real>& p) {
+    this->prepare(p);
+
+    #pragma omp parallel for
+    for (int i = 0; i < p.size(); i++) {
+        this->startX[i] = p.px[i];
+        this->startY[i] = p.py[i];
+        this->startZ[i] = p.pz[i];
+    }
+}
+
+/**
+ * sweeps every point from its start to its current position against the walls and the obstacles,
+ * a point that hit one bounces off at the impact and moves on for the rest of the step
+ * @param ParticleStore <Real>& p - the cube's particles after the step
+ * @param double timeStep - dt of the step
+ * @param double restitution - fraction of the velocity into the surface that comes back out
+ * @return int - points with an impact
+ */
+template <typename Real>
+int SweptCollider<Real>::resolve(ParticleStore <Real>& p, double timeStep, double restitution) {
+    if (!this->buffers.fits(p.size())) {
+        return 0;
+    }
+    const bool obstacles = colliders != nullptr && !colliders->empty();
+
+    int impacts = 0;
+    #pragma omp parallel for schedule(dynamic, 256) reduction(+:impacts)
+    for (int i = 0; i < p.size(); i++) {
+        if (p.isFixed(i)) {
+            continue;
+        }
+        glm::dvec3 from = glm::dvec3(this->startX[i], this->startY[i], this->startZ[i]);
+        glm::dvec3 to = glm::dvec3(p.getPosition(i));
+        if (from == to) {
+            continue;
+        }
+
+        glm::dvec3 velocity = glm::dvec3(p.getVelocity(i));
+        double remaining = timeStep;
+        bool hit = false;
+        bool ended = false;
+        for (int bounce = 0; bounce < MAX_BOUNCES; bounce++) {
+            glm::dvec3 normal;
+            double t = sweepBox(from, to, boundingBox, normal);
+            if (obstacles) {
+                glm::dvec3 obstacleNormal;
+                const double u = colliders->sweep(from, to, obstacleNormal);
+                if (u < t) {
+                    t = u;
+                    normal = obstacleNormal;
+                }
+            }
+            if (t > 1.0) {
+                ended = true;
+                break;
+            }
+
+            // bounce at the impact, the rest of the step moves on with the reflected velocity
+            hit = true;
+            const glm::dvec3 impact = from + t * (to - from);
+            const double approach = glm::dot(velocity, normal);
+            if (approach < 0.0) {
+                velocity -= (1.0 + restitution) * approach * normal;
+            }
+            remaining *= 1.0 - t;
+            from = impact;
+            to = impact + velocity * remaining;
+        }
+
+        if (hit) {
+            if (!ended) {
+                // out of bounces (wedged in a corner), the point stays at its last impact
+                to = from;
+            }
+            p.setPosition(i, glm::vec<3, Real>(to));
+            p.setVelocity(i, glm::vec<3, Real>(velocity));
+            impacts++;
+        }
+    }
+    return impacts;
+}
+
+template class SweptCollider <float>;
+template class SweptCollider <double>;
@@ -0,0 +1,46 @@
+#ifndef __SWEPTCOLLIDER_H__
+#define __SWEPTCOLLIDER_H__
+
+#include "Arena.h"
+#include "ParticleStore.h"
+
+class Cube;
+
+// what the last swept step found, shown in the ui
+struct SweptCollisionStats {
+    // points that hit a wall or an obstacle on their way through the step
+    int impacts = 0;
+};
+
+// continuous collision of the points with the walls of the bounding box and the obstacles:
+// every point moves on a straight line from its position at the start of the step to the one the integrator
+// left, the first wall or obstacle on that line is the impact (time of impact as a fraction of the step),
+// the point bounces there: the velocity into the surface is reflected with the restitution and the point moves on
+// with the rest of the step (up to MAX_BOUNCES impacts, for edges and corners); points that hit at different times
+// end apart, so a column of points that crossed a wall in one step does not collapse onto one spot
+// a point that starts the step inside a wall or an obstacle is left to the penalty response
+// Real is the precision of the particles it reads
+template <typename Real>
+class SweptCollider {
+
+    public:
+        SweptCollider() {}; // default constructor
+
+        static const int MAX_BOUNCES = 4;
+
+        // keeps the positions at the start of a step
+        void begin(const ParticleStore <Real>& p);
+        // moves every point that went through a wall or an obstacle back to its impact, returns the points with one
+        int resolve(ParticleStore <Real>& p, double timeStep, double restitution);
+        void clear() { this->buffers.clear(); }
+
+    private:
+        // start positions
+        ParticleBuffers buffers{};
+
+        Real *startX = nullptr, *startY = nullptr, *startZ = nullptr;
+
+        void prepare(const ParticleStore <Real>& p);
+};
+
+#endif
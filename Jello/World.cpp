@@ -0,0 +1,289 @@
+#include "World.h"
+#include "Physics.h"
+
+#include <algorithm>
+
+World::~World() {
+    this->resize(0);
+}
+
+/**
+ * creates a cube owned by the world, its points are built by setSpringMode or reset once its parameters are set
+ * @param int resolution - points per side
+ * @param glm::vec3 position - position of the cube (frame shared by all cubes of the world)
+ * @param GLint shader, GLint debug - shaders of the cube
+ * @return Cube* - the new cube
+ */
+Cube* World::addCube(int resolution, glm::vec3 position, GLint shader, GLint debug) {
+    Cube* cube = new Cube(resolution, position, shader, debug);
+    this->cubes.push_back(cube);
+    // new cubes join the sweep at the end, the next sort moves them into place
+    this->order.push_back(int(this->cubes.size()) - 1);
+    return cube;
+}
+
+void World::resize(int count) {
+    count = std::max(0, count);
+    for (int i = count; i < int(this->cubes.size()); i++) {
+        delete this->cubes[i];
+    }
+    if (count < int(this->cubes.size())) {
+        this->cubes.resize(count);
+        this->order.erase(std::remove_if(this->order.begin(), this->order.end(), [count](int i) { return i >= count; }), this->order.end());
+    }
+}
+
+// bounds of every cube from its points, grown by the contact thickness
+void World::refit() {
+    const int count = this->size();
+    this->bounds.resize(count);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < count; c++) {
+        Cube* cube = this->cubes[c];
+        ColliderBounds box{ glm::dvec3(cube->getPosition(0)), glm::dvec3(cube->getPosition(0)) };
+        for (int i = 1; i < cube->pointCount(); i++) {
+            const glm::dvec3 position = cube->getPosition(i);
+            box.min = glm::min(box.min, position);
+            box.max = glm::max(box.max, position);
+        }
+        box.min -= glm::dvec3(this->contactThickness);
+        box.max += glm::dvec3(this->contactThickness);
+        this->bounds[c] = box;
+    }
+}
+
+// insertion sort of the cubes along x, the order of the last step is almost sorted already
+void World::sortAxis() {
+    for (int k = 1; k < int(this->order.size()); k++) {
+        const int cube = this->order[k];
+        const double key = this->bounds[cube].min.x;
+        int j = k - 1;
+        while (j >= 0 && this->bounds[this->order[j]].min.x > key) {
+            this->order[j + 1] = this->order[j];
+            j--;
+        }
+        this->order[j + 1] = cube;
+    }
+}
+
+// sweep along x, every cube is tested against the ones whose x range is still open
+void World::findPairs() {
+    this->pairs.clear();
+    for (int k = 0; k < int(this->order.size()); k++) {
+        const ColliderBounds& a = this->bounds[this->order[k]];
+        for (int j = k + 1; j < int(this->order.size()); j++) {
+            const ColliderBounds& b = this->bounds[this->order[j]];
+            if (b.min.x > a.max.x) {
+                // sorted: no later cube starts before a ends
+                break;
+            }
+            if (a.overlaps(b)) {
+                this->pairs.push_back({ this->order[k], this->order[j] });
+            }
+        }
+    }
+}
+
+// depth under the surface of a cube down to which a point of another cube is still pushed out, one lattice spacing
+static double insideDepth(const Cube* cube) {
+    return 1.0 / double(std::max(1, cube->resolution - 1));
+}
+
+// harmonic mean, the softer of two cubes dominates their contact like two springs in series
+static double harmonicMean(double a, double b) {
+    return a + b > 0.0 ? 2.0 * a * b / (a + b) : 0.0;
+}
+
+/**
+ * contact acceleration of the surface points of a against the surface triangles of b, the opposite forces on
+ * the triangles are recorded for b
+ * @param Cube* a - cube whose points are pushed
+ * @param const ParticleStore <RealA>& pa - its particles
+ * @param const SelfCollider <RealA>& sa - its surface
+ * @param Cube* b - the other cube
+ * @param int other - index of b in the world
+ * @param const ParticleStore <RealB>& pb - particles of the other cube
+ * @param const SelfCollider <RealB>& sb - triangle hash of the other cube
+ * @param const ColliderBounds& region - overlap of the two bounds, points outside it cannot touch b
+ * @param double thickness - contact distance
+ * @param double inside - depth under the surface of b that still pushes a point out
+ * @param std::vector <BodyReaction>& reactions - receives the push of every contact on its triangle
+ * @return int - points of a touching b
+ */
+template <typename RealA, typename RealB>
+static int collideSurface(Cube* a, const ParticleStore <RealA>& pa, const SelfCollider <RealA>& sa, Cube* b, int other,
+    const ParticleStore <RealB>& pb, const SelfCollider <RealB>& sb, const ColliderBounds& region, double thickness, double inside,
+    std::vector <BodyReaction>& reactions) {
+    const double stiffness = harmonicMean(double(a->stiffness), double(b->stiffness));
+    const double damping = harmonicMean(double(a->damping), double(b->damping)) * 50.0;
+    const double inverseMass = 1.0 / double(a->mass);
+    const int* surface = sa.getSurface();
+    glm::dvec3* contact = a->bodyContact.data();
+
+    int contacts = 0;
+    for (int s = 0; s < sa.getSurfaceCount(); s++) {
+        const int i = surface[s];
+        const glm::dvec3 x = glm::dvec3(pa.getPosition(i));
+        if (!region.contains(x)) {
+            continue;
+        }
+
+        TriangleContact found[16];
+        const int count = sb.findTriangles(pb, x, thickness, inside, found, 16);
+        if (count == 0) {
+            continue;
+        }
+
+        // only the closest triangle pushes, like the distance to a solid: a point under the surface (depth beyond
+        // the thickness) goes out through the nearest face, a point outside away from the closest one
+        int closest = 0;
+        for (int f = 1; f < count; f++) {
+            const bool under = found[f].depth > thickness, closestUnder = found[closest].depth > thickness;
+            if (under != closestUnder ? under : (under ? found[f].depth < found[closest].depth : found[f].depth > found[closest].depth)) {
+                closest = f;
+            }
+        }
+        const TriangleContact& hit = found[closest];
+        const int* corner = sb.getTriangle(hit.triangle);
+        const glm::dvec3 closestVelocity = hit.weights.x * glm::dvec3(pb.getVelocity(corner[0]))
+            + hit.weights.y * glm::dvec3(pb.getVelocity(corner[1])) + hit.weights.z * glm::dvec3(pb.getVelocity(corner[2]));
+        const double approach = glm::dot(glm::dvec3(pa.getVelocity(i)) - closestVelocity, hit.normal);
+        const glm::dvec3 force = (stiffness * hit.depth - damping * approach) * hit.normal;
+        contact[i] += force * inverseMass;
+        reactions.push_back({ other, { corner[0], corner[1], corner[2] }, hit.weights, force });
+        contacts++;
+    }
+    return contacts;
+}
+
+/**
+ * points of a against the triangles of b, in the precisions the two cubes were built with
+ * @return int - points of a touching b
+ */
+int World::collide(Cube* a, int other, const ColliderBounds& region, std::vector <BodyReaction>& reactions) {
+    Cube* b = this->cubes[other];
+    const double thickness = this->contactThickness;
+    const double inside = insideDepth(b);
+    if (a->getPrecision() == PRECISION_FLOAT) {
+        if (b->getPrecision() == PRECISION_FLOAT) {
+            return collideSurface(a, a->particlesFloat, a->selfColliderFloat, b, other, b->particlesFloat, b->selfColliderFloat, region, thickness, inside, reactions);
+        }
+        return collideSurface(a, a->particlesFloat, a->selfColliderFloat, b, other, b->particles, b->selfCollider, region, thickness, inside, reactions);
+    }
+    if (b->getPrecision() == PRECISION_FLOAT) {
+        return collideSurface(a, a->particles, a->selfCollider, b, other, b->particlesFloat, b->selfColliderFloat, region, thickness, inside, reactions);
+    }
+    return collideSurface(a, a->particles, a->selfCollider, b, other, b->particles, b->selfCollider, region, thickness, inside, reactions);
+}
+
+/**
+ * finds the contact acceleration of every cube against the others for the current positions:
+ * refit the bounds, repair the sweep order, find the overlapping pairs and test both directions of every pair
+ */
+void World::updateContacts() {
+    const int count = this->size();
+
+    // contacts of the last step, accelerations kept by velocity Verlet included them
+    for (Cube* cube : this->cubes) {
+        if (int(cube->bodyContact.size()) != cube->pointCount()) {
+            cube->bodyContact.assign(cube->pointCount(), glm::dvec3(0.0));
+        }
+        else if (cube->bodyContacts > 0) {
+            std::fill(cube->bodyContact.begin(), cube->bodyContact.end(), glm::dvec3(0.0));
+            cube->accelerationCurrent = false;
+        }
+        cube->bodyContacts = 0;
+    }
+
+    this->refit();
+    this->sortAxis();
+    this->findPairs();
+
+    // partners of every cube (both directions of every pair, counting sort by cube)
+    this->partnerStart.assign(size_t(count) + 1, 0);
+    for (const std::pair <int, int>& pair : this->pairs) {
+        this->partnerStart[pair.first + 1]++;
+        this->partnerStart[pair.second + 1]++;
+    }
+    for (int c = 0; c < count; c++) {
+        this->partnerStart[c + 1] += this->partnerStart[c];
+    }
+    this->partners.resize(2 * this->pairs.size());
+    std::vector <int>& next = this->partnerNext;
+    next.assign(this->partnerStart.begin(), this->partnerStart.end() - 1);
+    for (const std::pair <int, int>& pair : this->pairs) {
+        this->partners[next[pair.first]++] = pair.second;
+        this->partners[next[pair.second]++] = pair.first;
+    }
+
+    // triangle hash of every cube in a pair
+    #pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < count; c++) {
+        if (this->partnerStart[c + 1] > this->partnerStart[c]) {
+            Cube* cube = this->cubes[c];
+            if (cube->getPrecision() == PRECISION_FLOAT) {
+                cube->selfColliderFloat.update(cube, cube->particlesFloat, this->contactThickness + insideDepth(cube));
+            }
+            else {
+                cube->selfCollider.update(cube, cube->particles, this->contactThickness + insideDepth(cube));
+            }
+        }
+    }
+
+    // one thread per cube against all its partners, it only writes the contacts of its own points
+    // and the pushes of its own points
+    this->reactions.resize(count);
+    int contacts = 0;
+    #pragma omp parallel for schedule(dynamic) reduction(+:contacts)
+    for (int c = 0; c < count; c++) {
+        Cube* a = this->cubes[c];
+        this->reactions[c].clear();
+        for (int k = this->partnerStart[c]; k < this->partnerStart[c + 1]; k++) {
+            const int other = this->partners[k];
+            ColliderBounds region;
+            region.min = glm::max(this->bounds[c].min, this->bounds[other].min);
+            region.max = glm::min(this->bounds[c].max, this->bounds[other].max);
+            a->bodyContacts += this->collide(a, other, region, this->reactions[c]);
+        }
+        contacts += a->bodyContacts;
+    }
+
+    // one thread per cube collects the pushes of its partners on its triangles
+    #pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < count; c++) {
+        Cube* b = this->cubes[c];
+        glm::dvec3* contact = b->bodyContact.data();
+        const double inverseMass = 1.0 / double(b->mass);
+        for (int k = this->partnerStart[c]; k < this->partnerStart[c + 1]; k++) {
+            for (const BodyReaction& reaction : this->reactions[this->partners[k]]) {
+                if (reaction.cube != c) {
+                    continue;
+                }
+                for (int n = 0; n < 3; n++) {
+                    contact[reaction.corner[n]] -= reaction.weights[n] * reaction.force * inverseMass;
+                }
+                // the corners count as touching, so the contacts are applied and cleared
+                b->bodyContacts++;
+            }
+        }
+        if (b->bodyContacts > 0) {
+            b->accelerationCurrent = false;
+        }
+    }
+
+    this->stats.pairs = int(this->pairs.size());
+    this->stats.contacts = contacts;
+}
+
+/**
+ * one step of the whole world
+ * @param double timeStep - dt
+ * @param integrate - advances one cube by one step (the integrator of the scene)
+ */
+void World::step(double timeStep, const std::function<void(Cube*, double)>& integrate) {
+    this->updateContacts();
+    for (Cube* cube : this->cubes) {
+        integrate(cube, timeStep);
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef __WORLD_H__
+#define __WORLD_H__
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <functional>
+
+#include "Collider.h"
+
+class Cube;
+
+// push of a point of one cube on a triangle of another, applied to the corners of the triangle by their weights
+struct BodyReaction {
+    // cube of the triangle, its corners (particle indices) and the barycentric weights of the closest point
+    int cube;
+    int corner[3];
+    glm::dvec3 weights;
+    // force on the point, the triangle takes the opposite
+    glm::dvec3 force;
+};
+
+// what the last contact update found, shown in the ui
+struct WorldStats {
+    // pairs whose bounds overlap (broadphase) and points touching another cube (narrowphase)
+    int pairs = 0;
+    int contacts = 0;
+};
+
+// a scene of many cubes, every cube keeps its own parameters (resolution, stiffness, damping, mass, precision...)
+// the points of all cubes live in one frame: the cubes are created at the same position and placed apart by
+// their lattice origin, so the box and the obstacles act on all of them alike
+// cubes touch each other through their surfaces: a surface point of one cube closer than the contact thickness
+// to a surface triangle of another one is pushed out like a wall contact (spring with the thickness as rest
+// length, damped along the normal against the velocity of the closest point on the triangle); a point that got
+// behind a triangle (less than a lattice spacing deep) is pushed back out along the normal of the triangle, only
+// the closest triangle of the other cube pushes a point
+// the corners of the triangle take the opposite force by their weights, stiffness and damping of a contact are
+// the harmonic means of the two cubes' values and every cube divides by its own mass, so the push is equal and
+// opposite between cubes of different parameters
+// broadphase: sweep and prune over the bounds of the cubes, the order along x is kept between steps and repaired
+// with an insertion sort, which is linear while the cubes move little per step
+// narrowphase: the points of one cube look up the triangle hash of the other one (SelfCollider)
+// contact accelerations are found once at the start of a step and held over it (Cube::bodyContact), so every
+// cube integrates on its own and the order of the cubes does not matter
+class World {
+
+    public:
+        World() {}; // default constructor
+        ~World();
+        World(const World&) = delete;
+        World& operator=(const World&) = delete;
+
+        // the world owns its cubes
+        Cube* addCube(int resolution, glm::vec3 position, GLint shader, GLint debug);
+        // deletes the cubes from count on
+        void resize(int count);
+        int size() const { return int(this->cubes.size()); }
+        Cube* getCube(int i) const { return this->cubes[i]; }
+
+        // distance (m) at which surfaces of different cubes start to push each other apart
+        double contactThickness = 0.05;
+
+        // broadphase and narrowphase for the current positions
+        void updateContacts();
+        // contacts, then integrate(cube, timeStep) for every cube
+        void step(double timeStep, const std::function<void(Cube*, double)>& integrate);
+
+        const WorldStats& getStats() const { return this->stats; }
+
+    private:
+        std::vector <Cube*> cubes{};
+        // bounds of every cube grown by the contact thickness
+        std::vector <ColliderBounds> bounds{};
+        // cubes sorted by the lower end of their bounds along x
+        std::vector <int> order{};
+        // overlapping pairs of the last update, and the other cube of every pair per cube
+        // (partners[partnerStart[c]] ... partners[partnerStart[c + 1] - 1])
+        std::vector <std::pair <int, int>> pairs{};
+        std::vector <int> partnerStart{};
+        std::vector <int> partners{};
+        std::vector <int> partnerNext{};
+        // pushes of the points of every cube on the triangles of its partners (kept between steps, no allocation
+        // once they are large enough)
+        std::vector <std::vector <BodyReaction>> reactions{};
+        WorldStats stats{};
+
+        void refit();
+        void sortAxis();
+        void findPairs();
+        int collide(Cube* a, int b, const ColliderBounds& region, std::vector <BodyReaction>& reactions);
+};
+
+#endif
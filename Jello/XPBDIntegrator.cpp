@@ -0,0 +1,195 @@
+#include "XPBDIntegrator.h"
+#include "Physics.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * lays out the previous positions and the multipliers for the current topology
+ * @param Cube* cube - cube to integrate
+ * @param const ParticleStore <Real>& current - state at the start of the step
+ */
+template <typename Real>
+void XPBDIntegrator<Real>::prepare(Cube* cube, const ParticleStore <Real>& current) {
+    const int count = current.size();
+    const int springCount = cube->springs.size();
+    if (this->buffers.fits(count, springCount)) {
+        return;
+    }
+
+    Arena& arena = this->buffers.resize(count, springCount, 3 * Arena::bytesFor<Real>(count) + Arena::bytesFor<Real>(springCount));
+    this->previousX = arena.allocate<Real>(count);
+    this->previousY = arena.allocate<Real>(count);
+    this->previousZ = arena.allocate<Real>(count);
+    this->lambda = arena.allocate<Real>(springCount);
+}
+
+/**
+ * keeps the positions and moves every free point with its velocity after the external forces
+ * and the contacts with the other cubes of the world, starts the multipliers of the substep at 0
+ * @param Cube* cube - cube to integrate
+ * @param ParticleStore <Real>& p - the cube's particles
+ * @param Real timeStep - substep
+ */
+template <typename Real>
+void XPBDIntegrator<Real>::predict(Cube* cube, ParticleStore <Real>& p, Real timeStep) {
+    typedef glm::vec<3, Real> vec3;
+    const vec3 externalAcc = vec3(cube->externalForce / double(cube->mass));
+    // held over the step like in computeAcceleration
+    const glm::dvec3* bodyContact = cube->bodyContacts > 0 ? cube->bodyContact.data() : nullptr;
+
+    #pragma omp parallel for
+    for (int i = 0; i < p.size(); i++) {
+        this->previousX[i] = p.px[i];
+        this->previousY[i] = p.py[i];
+        this->previousZ[i] = p.pz[i];
+
+        if (p.isFixed(i) == true) {
+            // moved by the plate
+            continue;
+        }
+
+        const vec3 acceleration = bodyContact != nullptr ? externalAcc + vec3(bodyContact[i]) : externalAcc;
+        p.vx[i] += acceleration.x * timeStep;
+        p.vy[i] += acceleration.y * timeStep;
+        p.vz[i] += acceleration.z * timeStep;
+
+        p.px[i] += p.vx[i] * timeStep;
+        p.py[i] += p.vy[i] * timeStep;
+        p.pz[i] += p.vz[i] * timeStep;
+    }
+
+    std::fill(this->lambda, this->lambda + this->buffers.springCount(), Real(0));
+}
+
+/**
+ * one Gauss-Seidel pass over every spring as a distance constraint C = |xa - xb| - rest,
+ * dlambda = (-C - alpha * lambda) / (wa + wb + alpha), alpha = compliance / dt^2
+ * springs of a color never share a point, so the colors are projected in parallel
+ * @param Cube* cube - cube to integrate
+ * @param ParticleStore <Real>& p - the cube's particles
+ * @param Real timeStep - substep
+ */
+template <typename Real>
+void XPBDIntegrator<Real>::solveSprings(Cube* cube, ParticleStore <Real>& p, Real timeStep) {
+    typedef glm::vec<3, Real> vec3;
+    const SpringTable& springs = cube->springs;
+    const Real* restLength = springs.getRestLength<Real>();
+    const Real inverseMass = Real(1) / Real(cube->mass);
+
+    // compliance per spring type, scaled by the substep
+    Real alpha[SPRING_TYPE_COUNT];
+    for (int t = 0; t < SPRING_TYPE_COUNT; t++) {
+        const Real k = Real(cube->stiffness) * Real(cube->springTypeStiffness[t]);
+        // zero stiffness is an inactive spring
+        alpha[t] = k > Real(0) ? Real(1) / (k * timeStep * timeStep) : Real(-1);
+    }
+
+    springs.forEachColored([&](int s) {
+        const Real a = alpha[springs.type[s]];
+        if (a < Real(0)) {
+            return;
+        }
+
+        const int pointA = springs.pointA[s];
+        const int pointB = springs.pointB[s];
+        const Real wa = p.isFixed(pointA) ? Real(0) : inverseMass;
+        const Real wb = p.isFixed(pointB) ? Real(0) : inverseMass;
+        const vec3 L = p.getPosition(pointA) - p.getPosition(pointB);
+        const Real length = glm::length(L);
+        if (wa + wb == Real(0) || length == Real(0)) {
+            return;
+        }
+
+        const vec3 n = L / length;
+        const Real C = length - restLength[s];
+        const Real dLambda = (-C - a * this->lambda[s]) / (wa + wb + a);
+        this->lambda[s] += dLambda;
+
+        const vec3 correction = dLambda * n;
+        p.setPosition(pointA, p.getPosition(pointA) + wa * correction);
+        p.setPosition(pointB, p.getPosition(pointB) - wb * correction);
+    });
+}
+
+/**
+ * projects every free point back into the bounding box, the six walls are hard inequality constraints
+ * (clamping to the box is the exact projection, corners and edges resolve in one pass), then out of the obstacles
+ * @param ParticleStore <Real>& p - the cube's particles
+ */
+template <typename Real>
+void XPBDIntegrator<Real>::solveContacts(ParticleStore <Real>& p) {
+    const Real minX = Real(boundingBox->minX), maxX = Real(boundingBox->maxX);
+    const Real minY = Real(boundingBox->minY), maxY = Real(boundingBox->maxY);
+    const Real minZ = Real(boundingBox->minZ), maxZ = Real(boundingBox->maxZ);
+
+    #pragma omp parallel for
+    for (int i = 0; i < p.size(); i++) {
+        if (p.isFixed(i) == true) {
+            continue;
+        }
+        p.px[i] = std::min(std::max(p.px[i], minX), maxX);
+        p.py[i] = std::min(std::max(p.py[i], minY), maxY);
+        p.pz[i] = std::min(std::max(p.pz[i], minZ), maxZ);
+    }
+
+    // obstacles
+    if (colliders != nullptr) {
+        colliders->project(p);
+    }
+}
+
+/**
+ * velocity from the change in position over the substep, then the spring damping
+ * @param Cube* cube - cube to integrate
+ * @param ParticleStore <Real>& p - the cube's particles
+ * @param Real timeStep - substep
+ */
+template <typename Real>
+void XPBDIntegrator<Real>::updateVelocities(Cube* cube, ParticleStore <Real>& p, Real timeStep) {
+    const Real inverseStep = Real(1) / timeStep;
+
+    #pragma omp parallel for
+    for (int i = 0; i < p.size(); i++) {
+        if (p.isFixed(i) == true) {
+            // velocity set by the plate
+            continue;
+        }
+        p.vx[i] = (p.px[i] - this->previousX[i]) * inverseStep;
+        p.vy[i] = (p.py[i] - this->previousY[i]) * inverseStep;
+        p.vz[i] = (p.pz[i] - this->previousZ[i]) * inverseStep;
+    }
+
+    applySpringDamping <Real>(cube, p, timeStep);
+}
+
+/**
+ * performs one XPBD step on the cube's particles, split into cube->xpbdSubsteps substeps
+ * of cube->xpbdIterations constraint passes each
+ * @param Cube* cube - cube to integrate
+ * @param double timeStep - dt
+ */
+template <typename Real>
+void XPBDIntegrator<Real>::step(Cube* cube, double timeStep) {
+    ParticleStore <Real>& current = cube->getParticles<Real>();
+    const int substeps = std::max(1, cube->xpbdSubsteps);
+    const int iterations = std::max(1, cube->xpbdIterations);
+    const Real h = Real(timeStep / double(substeps));
+    this->prepare(cube, current);
+
+    for (int s = 0; s < substeps; s++) {
+        this->predict(cube, current, h);
+        for (int it = 0; it < iterations; it++) {
+            this->solveSprings(cube, current, h);
+            this->solveContacts(current);
+        }
+        // once per substep, the hash is rebuilt for every query
+        if (cube->selfCollision) {
+            cube->getSelfCollider<Real>().project(cube, current);
+        }
+        this->updateVelocities(cube, current, h);
+    }
+}
+
+template class XPBDIntegrator <float>;
+template class XPBDIntegrator <double>;
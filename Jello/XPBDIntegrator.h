@@ -0,0 +1,40 @@
+#ifndef __XPBDINTEGRATOR_H__
+#define __XPBDINTEGRATOR_H__
+
+#include "ParticleStore.h"
+
+class Cube;
+
+// extended position based dynamics (XPBD) solver
+// every spring is a compliant distance constraint (compliance = 1 / stiffness), the bounding box walls
+// are hard inequality constraints and points fixed to the plate have infinite mass
+// a step is split into substeps, every substep predicts the positions from the velocities and external forces,
+// projects the constraints with Gauss-Seidel over the spring colors and derives the velocities from the
+// change in position, so it stays stable for any stiffness and time step
+// Real is the precision of the particles it integrates
+template <typename Real>
+class XPBDIntegrator {
+
+    public:
+        XPBDIntegrator() {}; // default constructor
+
+        void step(Cube* cube, double timeStep);
+        void clear() { this->buffers.clear(); }
+
+    private:
+        // every buffer below
+        ParticleBuffers buffers{};
+
+        // positions at the start of the substep
+        Real *previousX = nullptr, *previousY = nullptr, *previousZ = nullptr;
+        // accumulated lagrange multiplier of every spring in the current substep
+        Real* lambda = nullptr;
+
+        void prepare(Cube* cube, const ParticleStore <Real>& current);
+        void predict(Cube* cube, ParticleStore <Real>& p, Real timeStep);
+        void solveSprings(Cube* cube, ParticleStore <Real>& p, Real timeStep);
+        void solveContacts(ParticleStore <Real>& p);
+        void updateVelocities(Cube* cube, ParticleStore <Real>& p, Real timeStep);
+};
+
+#endif